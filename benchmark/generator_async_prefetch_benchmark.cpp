@@ -0,0 +1,48 @@
+#include <ext/generator_async_prefetch.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace
+{
+    constexpr std::int64_t element_count = 1 << 14;
+
+    // Simulated per-element work (parsing, decoding) of state.range(0) rounds.
+    std::int64_t work(std::int64_t x, std::int64_t rounds) noexcept
+    {
+        for (std::int64_t i = 0; i != rounds; ++i)
+            x = x * 6364136223846793005 + 1442695040888963407;
+        return x;
+    }
+
+    ext::generator_t<std::int64_t const &> ext_decode(std::int64_t n, std::int64_t rounds)
+    {
+        for (std::int64_t i = 0; i != n; ++i)
+            co_yield work(i, rounds);
+    }
+
+    template<typename range_t>
+    void consume(range_t &&range, std::int64_t rounds)
+    {
+        for (std::int64_t const &e : range)
+            benchmark::DoNotOptimize(work(e, rounds));
+    }
+} // namespace
+
+// Producer and consumer each do state.range(0) rounds of work per element, in one thread or overlapped through a ring of state.range(1) elements.
+static void bm_decode_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_decode(element_count, state.range(0)), state.range(0));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_decode_ext)->ArgsProduct({{0, 64, 1024}})->UseRealTime();
+
+static void bm_decode_async_prefetch_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext::async_prefetch(ext_decode(element_count, state.range(0)), static_cast<std::size_t>(state.range(1))), state.range(0));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_decode_async_prefetch_ext)->ArgsProduct({{0, 64, 1024}, {64, 1024}})->UseRealTime();
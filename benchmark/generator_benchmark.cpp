@@ -0,0 +1,646 @@
+#include <ext/generator.hpp>
+#include <ext/generator_hooks.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <string>
+#include <vector>
+#include <version>
+#if defined(__cpp_lib_generator)
+    #include <generator>
+#endif
+
+namespace
+{
+    constexpr std::int64_t element_count = 1 << 16;
+
+    // All generators yield std::int64_t const & so that ext::generator_t, std::generator and the hand-written iterators do the same amount of work per element.
+
+    struct hand_rolled_flat_t
+    {
+        std::int64_t n;
+        struct iterator_t
+        {
+            std::int64_t i;
+            using value_type = std::int64_t;
+            using difference_type = std::ptrdiff_t;
+            std::int64_t const &operator*() const noexcept { return i; }
+            iterator_t &operator++() noexcept
+            {
+                ++i;
+                return *this;
+            }
+            void operator++(int) noexcept { ++i; }
+            friend bool operator==(iterator_t const &iterator, std::int64_t n) noexcept { return iterator.i == n; }
+        };
+        iterator_t begin() const noexcept { return {.i = 0}; }
+        std::int64_t end() const noexcept { return n; }
+    };
+
+    // Implicit tree: a node at depth d yields d and then the elements of its width children at depth d - 1; nodes at depth 1 are leaves.
+    constexpr std::int64_t tree_size(std::int64_t depth, std::int64_t width) noexcept
+    {
+        std::int64_t size = 0;
+        for (std::int64_t level_size = 1; depth != 0; --depth, level_size *= width)
+            size += level_size;
+        return size;
+    }
+
+    struct hand_rolled_tree_t
+    {
+        std::int64_t depth, width;
+        struct frame_t
+        {
+            std::int64_t depth, children_left;
+        };
+        struct iterator_t
+        {
+            std::int64_t width;
+            std::vector<frame_t> stack;
+            using value_type = std::int64_t;
+            using difference_type = std::ptrdiff_t;
+            std::int64_t const &operator*() const noexcept { return stack.back().depth; }
+            iterator_t &operator++()
+            {
+                while (!stack.empty() && (stack.back().depth == 1 || stack.back().children_left == 0))
+                    stack.pop_back();
+                if (!stack.empty())
+                {
+                    --stack.back().children_left;
+                    stack.push_back({.depth = stack.back().depth - 1, .children_left = width});
+                }
+                return *this;
+            }
+            void operator++(int) { operator++(); }
+            friend bool operator==(iterator_t const &iterator, std::default_sentinel_t const &) noexcept { return iterator.stack.empty(); }
+        };
+        iterator_t begin() const
+        {
+            iterator_t iterator{.width = width};
+            iterator.stack.reserve(static_cast<std::size_t>(depth));
+            iterator.stack.push_back({.depth = depth, .children_left = width});
+            return iterator;
+        }
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+
+    ext::generator_t<std::int64_t const &> ext_flat(std::int64_t n)
+    {
+        for (std::int64_t i = 0; i != n; ++i)
+            co_yield i;
+    }
+
+    ext::generator_t<std::int64_t const &> ext_tree(std::int64_t depth, std::int64_t width)
+    {
+        co_yield depth;
+        if (depth != 1)
+            for (std::int64_t i = 0; i != width; ++i)
+                co_yield std::ranges::elements_of(ext_tree(depth - 1, width));
+    }
+
+    ext::lazy_generator_t<std::int64_t const &> ext_lazy_flat(std::int64_t n)
+    {
+        for (std::int64_t i = 0; i != n; ++i)
+            co_yield i;
+    }
+
+    ext::lazy_generator_t<std::int64_t const &> ext_lazy_tree(std::int64_t depth, std::int64_t width)
+    {
+        co_yield depth;
+        if (depth != 1)
+            for (std::int64_t i = 0; i != width; ++i)
+                co_yield std::ranges::elements_of(ext_lazy_tree(depth - 1, width));
+    }
+
+    // Every level creates (and so starts) its whole subtree before grafting it, like a recursive walk handing its results up through several levels.
+    ext::generator_t<std::int64_t const &> ext_started_chain(std::int64_t depth)
+    {
+        if (depth != 1)
+        {
+            ext::generator_t<std::int64_t const &> child = ext_started_chain(depth - 1);
+            co_yield std::ranges::elements_of(std::move(child));
+        }
+        co_yield depth;
+    }
+
+    ext::generator_t<std::int64_t const &> ext_elements_of_vectors(std::vector<std::vector<std::int64_t>> const &vectors)
+    {
+        for (std::vector<std::int64_t> const &vector : vectors)
+            co_yield std::ranges::elements_of(vector);
+    }
+
+    ext::generator_t<std::int64_t const &> ext_elements_of_vectors_hinted(std::vector<std::vector<std::int64_t>> const &vectors, std::int64_t n)
+    {
+        co_yield ext::generator_size_hint_t{.size = static_cast<std::size_t>(n)};
+        for (std::vector<std::int64_t> const &vector : vectors)
+            co_yield std::ranges::elements_of(vector);
+    }
+
+    ext::generator_t<std::int64_t const &> ext_elements_of_spans(std::vector<std::vector<std::int64_t>> const &vectors)
+    {
+        for (std::vector<std::int64_t> const &vector : vectors)
+            co_yield std::ranges::elements_of(std::span(vector));
+    }
+
+    ext::generator_t<std::int64_t const &> ext_elements_of_iotas(std::int64_t n, std::int64_t chunk_size)
+    {
+        for (std::int64_t i = 0; i < n; i += chunk_size)
+            co_yield std::ranges::elements_of(std::views::iota(i, i + chunk_size));
+    }
+
+    // Fills a buffer and hands it out as one contiguous chunk at a time.
+    ext::generator_t<std::int64_t const &> ext_buffered(std::int64_t n, std::int64_t buffer_size)
+    {
+        std::vector<std::int64_t> buffer(static_cast<std::size_t>(buffer_size));
+        for (std::int64_t i = 0; i < n; i += buffer_size)
+        {
+            std::iota(buffer.begin(), buffer.end(), i);
+            co_yield std::ranges::elements_of(std::span(buffer));
+        }
+    }
+
+#if defined(__cpp_lib_generator)
+    std::generator<std::int64_t const &> std_flat(std::int64_t n)
+    {
+        for (std::int64_t i = 0; i != n; ++i)
+            co_yield i;
+    }
+
+    std::generator<std::int64_t const &> std_tree(std::int64_t depth, std::int64_t width)
+    {
+        co_yield depth;
+        if (depth != 1)
+            for (std::int64_t i = 0; i != width; ++i)
+                co_yield std::ranges::elements_of(std_tree(depth - 1, width));
+    }
+
+    std::generator<std::int64_t const &> std_started_chain(std::int64_t depth)
+    {
+        if (depth != 1)
+        {
+            std::generator<std::int64_t const &> child = std_started_chain(depth - 1);
+            co_yield std::ranges::elements_of(std::move(child));
+        }
+        co_yield depth;
+    }
+
+    std::generator<std::int64_t const &> std_elements_of_vectors(std::vector<std::vector<std::int64_t>> const &vectors)
+    {
+        for (std::vector<std::int64_t> const &vector : vectors)
+            co_yield std::ranges::elements_of(vector);
+    }
+
+    std::generator<std::int64_t const &> std_elements_of_spans(std::vector<std::vector<std::int64_t>> const &vectors)
+    {
+        for (std::vector<std::int64_t> const &vector : vectors)
+            co_yield std::ranges::elements_of(std::span(vector));
+    }
+
+    std::generator<std::int64_t const &> std_elements_of_iotas(std::int64_t n, std::int64_t chunk_size)
+    {
+        for (std::int64_t i = 0; i < n; i += chunk_size)
+            co_yield std::ranges::elements_of(std::views::iota(i, i + chunk_size));
+    }
+#endif
+
+    // Same shapes as ext_flat and ext_tree with an explicit allocator, for comparing frame allocation strategies.
+    template<typename allocator_t>
+    ext::generator_t<std::int64_t const &> ext_flat(std::allocator_arg_t, allocator_t const &, std::int64_t n)
+    {
+        for (std::int64_t i = 0; i != n; ++i)
+            co_yield i;
+    }
+
+    template<typename allocator_t>
+    ext::generator_t<std::int64_t const &> ext_tree(std::allocator_arg_t, allocator_t const &allocator, std::int64_t depth, std::int64_t width)
+    {
+        co_yield depth;
+        if (depth != 1)
+            for (std::int64_t i = 0; i != width; ++i)
+                co_yield std::ranges::elements_of(ext_tree(std::allocator_arg, allocator, depth - 1, width));
+    }
+
+    // A candidate does some work before its first element; generator_t selects eager or lazy start.
+    template<typename generator_t>
+    generator_t ext_candidate(std::int64_t seed)
+    {
+        std::int64_t x = seed;
+        for (std::int64_t i = 0; i != 256; ++i)
+            x = x * 6364136223846793005 + 1442695040888963407;
+        co_yield x;
+        for (std::int64_t i = 0; i != element_count; ++i)
+            co_yield i;
+    }
+
+    struct caching_generator_traits_t : public ext::generator_traits_t
+    {
+        static constexpr bool caches_value = true;
+    };
+
+    // Yields strings that do not fit in the small string buffer from a char const *, which materializes a std::string per element unless the promise caches it.
+    template<typename traits_t>
+    ext::generator_t<std::string const &, void, void, traits_t> ext_strings(std::int64_t n)
+    {
+        static constexpr char const *texts[] = {"a string that does not fit in the small string buffer", "another string that does not fit in the small string buffer"};
+        for (std::int64_t i = 0; i != n; ++i)
+            co_yield texts[i & 1];
+    }
+
+    struct no_hooks_generator_traits_t : public ext::generator_traits_t // Spelled out so that the no-op hooks are measured through the same code path as the counting ones.
+    {
+        using hooks_t = ext::generator_no_hooks_t;
+    };
+    struct counting_generator_traits_t : public ext::generator_traits_t
+    {
+        using hooks_t = ext::generator_counting_hooks_t<counting_generator_traits_t>;
+    };
+
+    template<typename traits_t>
+    ext::generator_t<std::int64_t const &, void, void, traits_t> ext_hooked_tree(std::int64_t depth, std::int64_t width)
+    {
+        co_yield depth;
+        if (depth != 1)
+            for (std::int64_t i = 0; i != width; ++i)
+                co_yield std::ranges::elements_of(ext_hooked_tree<traits_t>(depth - 1, width));
+    }
+
+    std::vector<std::vector<std::int64_t>> make_vectors(std::int64_t n, std::int64_t chunk_size)
+    {
+        std::vector<std::vector<std::int64_t>> vectors;
+        for (std::int64_t i = 0; i < n; i += chunk_size)
+        {
+            auto iota = std::views::iota(i, i + chunk_size);
+            vectors.emplace_back(iota.begin(), iota.end());
+        }
+        return vectors;
+    }
+
+    template<typename range_t>
+    void consume(range_t &&range)
+    {
+        for (std::int64_t const &e : range)
+            benchmark::DoNotOptimize(e);
+    }
+} // namespace
+
+static void bm_flat_hand_rolled(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(hand_rolled_flat_t{.n = element_count});
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_flat_hand_rolled);
+
+static void bm_flat_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_flat(element_count));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_flat_ext);
+
+#if defined(__cpp_lib_generator)
+static void bm_flat_std(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(std_flat(element_count));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_flat_std);
+#endif
+
+// Deep: a chain of state.range(0) nested generators, one element per level.
+// Wide: one root grafting state.range(1) leaf generators.
+static void deep_arguments(benchmark::internal::Benchmark *benchmark)
+{
+    for (std::int64_t depth : {1, 10, 100, 1000, 10000})
+        benchmark->Args({depth, 1});
+}
+static void wide_arguments(benchmark::internal::Benchmark *benchmark)
+{
+    for (std::int64_t width : {16, 256, 4096, 65536})
+        benchmark->Args({2, width});
+}
+
+static void bm_tree_hand_rolled(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(hand_rolled_tree_t{.depth = state.range(0), .width = state.range(1)});
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_tree_hand_rolled)->Name("bm_deep_hand_rolled")->Apply(deep_arguments);
+BENCHMARK(bm_tree_hand_rolled)->Name("bm_wide_hand_rolled")->Apply(wide_arguments);
+
+static void bm_tree_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_tree(state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_tree_ext)->Name("bm_deep_ext")->Apply(deep_arguments);
+BENCHMARK(bm_tree_ext)->Name("bm_wide_ext")->Apply(wide_arguments);
+
+#if defined(__cpp_lib_generator)
+static void bm_tree_std(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(std_tree(state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_tree_std)->Name("bm_deep_std")->Apply(deep_arguments);
+BENCHMARK(bm_tree_std)->Name("bm_wide_std")->Apply(wide_arguments);
+#endif
+
+// Deep started: a chain of state.range(0) nested generators, each level grafting a subtree that has already run down to its leaf.
+static void bm_deep_started_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_started_chain(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_deep_started_ext)->RangeMultiplier(10)->Range(1, 10000);
+
+#if defined(__cpp_lib_generator)
+static void bm_deep_started_std(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(std_started_chain(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_deep_started_std)->RangeMultiplier(10)->Range(1, 10000);
+#endif
+
+// elements_of over plain ranges: element_count elements split into ranges of state.range(0) elements each.
+static void chunk_size_arguments(benchmark::internal::Benchmark *benchmark)
+{
+    for (std::int64_t chunk_size : {1, 4, 16, 64, 256})
+        benchmark->Arg(chunk_size);
+}
+
+static void bm_elements_of_vector_hand_rolled(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+        consume(vectors | std::views::join);
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_vector_hand_rolled)->Apply(chunk_size_arguments);
+
+static void bm_elements_of_vector_ext(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+        consume(ext_elements_of_vectors(vectors));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_vector_ext)->Apply(chunk_size_arguments);
+
+static void bm_elements_of_span_ext(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+        consume(ext_elements_of_spans(vectors));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_span_ext)->Apply(chunk_size_arguments);
+
+static void bm_elements_of_iota_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_elements_of_iotas(element_count, state.range(0)));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_iota_ext)->Apply(chunk_size_arguments);
+
+#if defined(__cpp_lib_generator)
+static void bm_elements_of_vector_std(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+        consume(std_elements_of_vectors(vectors));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_vector_std)->Apply(chunk_size_arguments);
+
+static void bm_elements_of_span_std(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+        consume(std_elements_of_spans(vectors));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_span_std)->Apply(chunk_size_arguments);
+
+static void bm_elements_of_iota_std(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(std_elements_of_iotas(element_count, state.range(0)));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_elements_of_iota_std)->Apply(chunk_size_arguments);
+#endif
+
+// Summing a buffered producer's output: element by element, or chunk by chunk where the compiler can vectorize the inner loop.
+static void bm_sum_hand_rolled(benchmark::State &state)
+{
+    std::vector<std::int64_t> vector(static_cast<std::size_t>(element_count));
+    std::iota(vector.begin(), vector.end(), std::int64_t(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(std::accumulate(vector.begin(), vector.end(), std::int64_t(0)));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_sum_hand_rolled);
+
+static void bm_sum_elements_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        std::int64_t sum = 0;
+        for (std::int64_t const &e : ext_buffered(element_count, state.range(0)))
+            sum += e;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_sum_elements_ext)->Apply(chunk_size_arguments);
+
+static void bm_sum_chunks_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        std::int64_t sum = 0;
+        ext::generator_t<std::int64_t const &> generator = ext_buffered(element_count, state.range(0));
+        for (std::span<std::int64_t const> chunk : generator.chunks())
+            sum = std::accumulate(chunk.begin(), chunk.end(), sum);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_sum_chunks_ext)->Apply(chunk_size_arguments);
+
+// Frame allocation: element_count short-lived single-element generators, and wide trees whose leaves are created and destroyed one after another.
+// "malloc" passes std::allocator<void> explicitly, "pool" passes a generator_frame_pool_allocator_t explicitly and "default" uses the default allocator with a pool installed as the thread-local pool.
+static void bm_short_lived_malloc_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        for (std::int64_t i = 0; i != element_count; ++i)
+            consume(ext_flat(std::allocator_arg, std::allocator<void>(), 1));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_short_lived_malloc_ext);
+
+static void bm_short_lived_pool_ext(benchmark::State &state)
+{
+    ext::generator_frame_pool_t pool;
+    for (auto _ : state)
+        for (std::int64_t i = 0; i != element_count; ++i)
+            consume(ext_flat(std::allocator_arg, ext::generator_frame_pool_allocator_t<void>(pool), 1));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_short_lived_pool_ext);
+
+static void bm_short_lived_default_ext(benchmark::State &state)
+{
+    ext::generator_frame_pool_t pool;
+    ext::generator_frame_pool_t::thread_local_scope_t scope(pool);
+    for (auto _ : state)
+        for (std::int64_t i = 0; i != element_count; ++i)
+            consume(ext_flat(1));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_short_lived_default_ext);
+
+static void bm_wide_malloc_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_tree(std::allocator_arg, std::allocator<void>(), state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_wide_malloc_ext)->Apply(wide_arguments)->Args({4, 16});
+
+static void bm_wide_pool_ext(benchmark::State &state)
+{
+    ext::generator_frame_pool_t pool;
+    for (auto _ : state)
+        consume(ext_tree(std::allocator_arg, ext::generator_frame_pool_allocator_t<void>(pool), state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_wide_pool_ext)->Apply(wide_arguments)->Args({4, 16});
+
+static void bm_wide_default_ext(benchmark::State &state)
+{
+    ext::generator_frame_pool_t pool;
+    ext::generator_frame_pool_t::thread_local_scope_t scope(pool);
+    for (auto _ : state)
+        consume(ext_tree(state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_wide_default_ext)->Apply(wide_arguments)->Args({4, 16});
+
+// Speculative pipeline: build state.range(0) candidate generators and consume only the first element of one of them.
+template<typename generator_t>
+static void bm_speculative_ext(benchmark::State &state)
+{
+    std::vector<generator_t> candidates;
+    candidates.reserve(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i != state.range(0); ++i)
+            candidates.push_back(ext_candidate<generator_t>(i));
+        benchmark::DoNotOptimize(*candidates[candidates.size() / 2].begin());
+        candidates.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_speculative_ext<ext::generator_t<std::int64_t const &>>)->Name("bm_speculative_eager_ext")->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(bm_speculative_ext<ext::lazy_generator_t<std::int64_t const &>>)->Name("bm_speculative_lazy_ext")->RangeMultiplier(4)->Range(1, 256);
+
+// Lazy generators in the benchmarks above: the first element costs an extra resume and grafting an unstarted subtree resumes it by symmetric transfer.
+static void bm_flat_lazy_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_lazy_flat(element_count));
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_flat_lazy_ext);
+
+static void bm_tree_lazy_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_lazy_tree(state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_tree_lazy_ext)->Name("bm_deep_lazy_ext")->Apply(deep_arguments);
+BENCHMARK(bm_tree_lazy_ext)->Name("bm_wide_lazy_ext")->Apply(wide_arguments);
+
+// Cancellation: descend a lazy chain of state.range(0) frames to its leaf and abandon it, so that destroying the generator tears down the whole chain.
+static void bm_abandon_deep_lazy_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        ext::lazy_generator_t<std::int64_t const &> generator = ext_lazy_tree(state.range(0), 1);
+        auto iterator = generator.begin();
+        for (std::int64_t i = 1; i != state.range(0); ++i)
+            ++iterator;
+        benchmark::DoNotOptimize(*iterator);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_abandon_deep_lazy_ext)->RangeMultiplier(10)->Range(10, 1000000);
+
+// Yielding heavy values: element_count strings, with and without generator_traits_t::caches_value.
+template<typename traits_t>
+static void bm_strings_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        for (std::string const &e : ext_strings<traits_t>(element_count))
+            benchmark::DoNotOptimize(e.data());
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_strings_ext<ext::generator_traits_t>)->Name("bm_strings_ext");
+BENCHMARK(bm_strings_ext<caching_generator_traits_t>)->Name("bm_strings_caching_ext");
+
+// Instrumentation: generator_traits_t::hooks_t that do nothing should cost nothing (compare with bm_deep_ext and bm_wide_ext), the counting hooks cost a few relaxed atomic increments per element and per frame.
+template<typename traits_t>
+static void bm_tree_hooks_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+        consume(ext_hooked_tree<traits_t>(state.range(0), state.range(1)));
+    state.SetItemsProcessed(state.iterations() * tree_size(state.range(0), state.range(1)));
+}
+BENCHMARK(bm_tree_hooks_ext<no_hooks_generator_traits_t>)->Name("bm_deep_no_hooks_ext")->Apply(deep_arguments);
+BENCHMARK(bm_tree_hooks_ext<no_hooks_generator_traits_t>)->Name("bm_wide_no_hooks_ext")->Apply(wide_arguments);
+BENCHMARK(bm_tree_hooks_ext<counting_generator_traits_t>)->Name("bm_deep_counting_hooks_ext")->Apply(deep_arguments);
+BENCHMARK(bm_tree_hooks_ext<counting_generator_traits_t>)->Name("bm_wide_counting_hooks_ext")->Apply(wide_arguments);
+
+// Collecting into a std::vector: a push_back loop over the elements grows the vector repeatedly, drain_into() reserves for the declared size and inserts each chunk at once.
+static void bm_collect_push_back_ext(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+    {
+        std::vector<std::int64_t> collected;
+        for (std::int64_t const &e : ext_elements_of_vectors(vectors))
+            collected.push_back(e);
+        benchmark::DoNotOptimize(collected.data());
+    }
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_collect_push_back_ext)->Apply(chunk_size_arguments);
+
+static void bm_collect_drain_into_ext(benchmark::State &state)
+{
+    std::vector<std::vector<std::int64_t>> vectors = make_vectors(element_count, state.range(0));
+    for (auto _ : state)
+    {
+        std::vector<std::int64_t> collected;
+        ext_elements_of_vectors_hinted(vectors, element_count).drain_into(collected);
+        benchmark::DoNotOptimize(collected.data());
+    }
+    state.SetItemsProcessed(state.iterations() * element_count);
+}
+BENCHMARK(bm_collect_drain_into_ext)->Apply(chunk_size_arguments);
@@ -0,0 +1,56 @@
+#include <ext/generator_parallel.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    constexpr std::int64_t tree_depth = 12, tree_size = (std::int64_t(1) << tree_depth) - 1;
+
+    // Simulated per-node work (reading a directory, parsing a file) of rounds rounds.
+    std::int64_t work(std::int64_t x, std::int64_t rounds) noexcept
+    {
+        for (std::int64_t i = 0; i != rounds; ++i)
+            x = x * 6364136223846793005 + 1442695040888963407;
+        return x;
+    }
+
+    // Binary tree of tree_size nodes. Its subtrees take their arguments by value, so they can be spawned.
+    ext::generator_t<std::int64_t const &, void, void, ext::parallel_generator_traits_t> ext_scan(std::int64_t depth, std::int64_t rounds)
+    {
+        co_yield work(depth, rounds);
+        if (depth != 1)
+        {
+            co_yield std::ranges::elements_of(ext_scan(depth - 1, rounds));
+            co_yield std::ranges::elements_of(ext_scan(depth - 1, rounds));
+        }
+    }
+} // namespace
+
+// Scanning the tree with state.range(0) rounds of work per node, sequentially or with parallel_for_each on state.range(1) workers.
+static void bm_scan_ext(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        std::int64_t sum = 0;
+        for (std::int64_t const &e : ext_scan(tree_depth, state.range(0)))
+            sum += e;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * tree_size);
+}
+BENCHMARK(bm_scan_ext)->ArgsProduct({{0, 1024}})->UseRealTime();
+
+static void bm_scan_parallel_ext(benchmark::State &state)
+{
+    std::vector<std::int64_t> sums(static_cast<std::size_t>(state.range(1)));
+    for (auto _ : state)
+    {
+        ext::parallel_for_each(ext_scan(tree_depth, state.range(0)), [&sums](std::size_t worker_index, std::int64_t const &e) { sums[worker_index] += e; }, static_cast<std::size_t>(state.range(1)));
+        benchmark::DoNotOptimize(sums.data());
+    }
+    state.SetItemsProcessed(state.iterations() * tree_size);
+}
+BENCHMARK(bm_scan_parallel_ext)->ArgsProduct({{0, 1024}, {1, 2, 4}})->UseRealTime();
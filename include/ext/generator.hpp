@@ -1,58 +1,82 @@
+#pragma once
+
+#include <algorithm>
 #include <cassert>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <tuple>
 #include <type_traits>
-
-#if defined(ext_generator_debug)
-    #include <iostream>
-    #include <string_view>
-    #define if_ext_generator_debug(...) __VA_ARGS__
-namespace ext
-{
-    template<typename T>
-    constexpr auto type_name() // https://stackoverflow.com/questions/81870/is-it-possible-to-print-a-variables-type-in-standard-c/56766138#56766138
-    {
-        std::string_view name, prefix, suffix;
-    #ifdef __clang__
-        name = __PRETTY_FUNCTION__;
-        prefix = "auto type_name() [T = ";
-        suffix = "]";
-    #elif defined(__GNUC__)
-        name = __PRETTY_FUNCTION__;
-        prefix = "constexpr auto type_name() [with T = ";
-        suffix = "]";
-    #elif defined(_MSC_VER)
-        name = __FUNCSIG__;
-        prefix = "auto __cdecl type_name<";
-        suffix = ">(void)";
-    #endif
-        name.remove_prefix(prefix.size());
-        name.remove_suffix(suffix.size());
-        return name;
-    }
-} // namespace ext
-#else
-    #define if_ext_generator_debug(...)
-#endif
+#include <utility>
 
 namespace ext
 {
     template<typename allocator_t>
     concept type_agnostic_allocator_c = std::is_same_v<typename std::allocator_traits<allocator_t>::value_type, void>;
 
-    template<typename reference_t_, typename value_t_ = void, typename yielded_t_ = void> requires (std::is_void_v<yielded_t_> || std::is_reference_v<yielded_t_>)
+    struct generator_no_hooks_t // Instrumentation hooks of generator_traits_t: every hook is a static member function that does nothing, so the calls compile away. Derive from it and hide the hooks to observe.
+    {
+        static void on_frame_allocate([[maybe_unused]] std::size_t frame_size) noexcept {} // A coroutine state of frame_size bytes is allocated (after the allocator returns, so an allocation that throws is not reported).
+        static void on_frame_deallocate([[maybe_unused]] std::size_t frame_size) noexcept {} // A coroutine state of frame_size bytes is deallocated.
+        static void on_graft([[maybe_unused]] std::size_t depth) noexcept {} // co_yield std::ranges::elements_of(generator) grafts a subtree, whose active frame is now depth frames below the root.
+        static void on_resume() noexcept {} // The consumer resumes a coroutine (iterator_t::operator++() or start()), as opposed to advancing through elements_of(range) in place.
+        static void on_advance() noexcept {} // The consumer advances to the next element (iterator_t::operator++(), once per chunk for chunk_iterator_t).
+        static void on_exception([[maybe_unused]] std::size_t depth) noexcept {} // An exception escapes the coroutine body of a frame depth frames below the root: it is stored into *p_p_exception (depth != 0) or rethrown to the consumer (depth == 0).
+    };
+
+    struct generator_traits_t // Compile-time policy of generator_t. Derive from it and hide members to customize.
+    {
+        static constexpr bool lazy = false; // false: the coroutine body runs up to its first co_yield when the generator is created. true: it runs when the generator is first observed (begin(), empty(), chunks()) or grafted by co_yield std::ranges::elements_of(generator), so a generator that is discarded does no work.
+        static constexpr bool caches_value = false; // true: the promise keeps a std::remove_cvref_t<yielded_t> and co_yield expression constructs or assigns it in place (reusing e.g. a string's capacity) instead of materializing a temporary per element.
+        using hooks_t = generator_no_hooks_t; // Called on frame allocation, grafting, resumption, advancing and exceptions; a graft is reported by the hooks of the frame that grafts, other events by the hooks of the generator that is allocated, iterated or throws.
+        static constexpr bool spawns_in_parallel = false; // false: co_yield std::ranges::elements_of(generator) grafts the subtree and completes when it is done, also under ext::parallel_for_each. true: under ext::parallel_for_each, it hands the subtree to the pool and completes at once, so the subtree may outlive the coroutine's locals and parameters (it must not refer to them) and an exception escaping it is rethrown by parallel_for_each instead of by this co_yield.
+    };
+    struct lazy_generator_traits_t : public generator_traits_t
+    {
+        static constexpr bool lazy = true;
+    };
+    struct parallel_generator_traits_t : public generator_traits_t
+    {
+        static constexpr bool spawns_in_parallel = true;
+    };
+
+    template<typename reference_t_, typename value_t_ = void, typename yielded_t_ = void, typename traits_t_ = generator_traits_t> requires (std::is_void_v<yielded_t_> || std::is_reference_v<yielded_t_>)
     struct generator_t;
+    template<typename reference_t_, typename value_t_ = void, typename yielded_t_ = void>
+    using lazy_generator_t = generator_t<reference_t_, value_t_, yielded_t_, lazy_generator_traits_t>;
+
+    struct generator_size_hint_t // co_yield ext::generator_size_hint_t{.size = n} declares that the coroutine expects to produce about n more elements, without producing or suspending; generator_t::drain_into() reserves for what is left of them.
+    {
+        std::size_t size;
+    };
 
     template<typename yielded_t>
     struct generator_promise_base_t
     {
-        std::add_pointer_t<yielded_t> p_yielded;
-        generator_promise_base_t *p_promise_continuation, *p_promise_root_or_current; // Link promises into call tree to implement symmetric transfer. For root, p_promise_continuation = nullptr, p_promise_root_or_current = std::addressof(active_frame's promise). For non-root, p_promise_continuation = std::addressof(caller(parent)'s promise), p_promise_root_or_current = std::addressof(root's promise).
+        std::add_pointer_t<yielded_t> p_yielded, p_yielded_last; // [p_yielded, p_yielded_last] are the elements that can be produced without resuming the coroutine. After co_yield yielded, both are std::addressof(yielded). During co_yield std::ranges::elements_of(contiguous range), they span the rest of the range. Before the first co_yield, nullptr (the active frame of a started generator that is not done always has yielded, so p_yielded == nullptr there means a lazy generator has not started).
+        struct range_cursor_t
+        {
+            bool (*advance)(range_cursor_t &range_cursor, generator_promise_base_t &promise); // Produces the next element of the range in place, returns false when the coroutine needs to be resumed (the range is exhausted or an exception is stored).
+            std::size_t (*size)(range_cursor_t const &range_cursor, generator_promise_base_t const &promise) noexcept; // The number of elements left in the range, including the current one, or 0 if the range cannot tell in O(1).
+            std::size_t advanced; // The number of elements after the first that have been produced in place (for a contiguous range, all of them, whether or not p_yielded has reached them yet), which the root's size_hint is counted down by when the coroutine is resumed instead of per element.
+        } *p_range_cursor; // During co_yield std::ranges::elements_of(range), std::addressof(yield_range_awaitable_t), otherwise nullptr. For a contiguous range, advance is only called at its last element.
+        struct parallel_spawner_t
+        {
+            bool (*spawn)(parallel_spawner_t &parallel_spawner, std::coroutine_handle<generator_promise_base_t> handle) noexcept; // Takes ownership of a subtree's coroutine states to consume them as a separate root, possibly on another thread, returns false if it cannot (then the subtree is grafted as usual).
+        } *p_parallel_spawner; // For root, the spawner which co_yield std::ranges::elements_of(generator) in coroutines whose traits_t::spawns_in_parallel is true hands subtrees to instead of grafting them (see ext::parallel_for_each), or nullptr. For non-root, unspecified.
+        generator_promise_base_t *p_promise_continuation, *p_promise_root_or_current; // Link promises into call tree to implement symmetric transfer. For root, p_promise_continuation = nullptr, p_promise_root_or_current = std::addressof(active_frame's promise). For non-root, p_promise_continuation = std::addressof(caller(parent)'s promise), p_promise_root_or_current = std::addressof(root's promise) if it is the active frame, otherwise unspecified (only the active frame grafts and pops, so only it needs to find the root, which keeps both O(1) regardless of depth).
         std::exception_ptr *p_p_exception; // For root, nullptr. For non-root, std::addressof(caller(parent)'s yield_awaitable_t's p_exception).
+        std::coroutine_handle<generator_promise_base_t> *p_handle_owner; // For root, nullptr. For non-root, std::addressof(caller(parent)'s yield_awaitable_t's generator.handle), which owns this coroutine state and is cleared when the tree is destroyed from the active frame upwards (see generator_t::destroy).
+        std::size_t size_hint; // Number of elements the coroutine declared it expects to produce from where it declared it (co_yield generator_size_hint_t), 0 if it declared none. For root, counted down as elements are consumed (until 0) and reported by generator_t::size_hint(). For non-root, unused.
+        std::size_t active_depth; // For root, the number of frames between it and the active frame (0 if the root is the active frame), adjusted by grafts and pops in O(1) and reported to generator_traits_t::hooks_t. For non-root, unspecified.
 
-        generator_promise_base_t() noexcept : p_promise_continuation(nullptr), p_promise_root_or_current(this), p_p_exception(nullptr) {}
-        std::suspend_never initial_suspend() const noexcept { return {}; }
+        generator_promise_base_t() noexcept : p_yielded(nullptr), p_yielded_last(nullptr), p_range_cursor(nullptr), p_parallel_spawner(nullptr), p_promise_continuation(nullptr), p_promise_root_or_current(this), p_p_exception(nullptr), p_handle_owner(nullptr), size_hint(0uz), active_depth(0uz) {}
         struct final_awaitable_t
         {
             bool await_ready() const noexcept { return false; }
@@ -63,6 +87,8 @@ namespace ext
                 if (generator_promise_base_t *p_promise_root = promise_continuation.p_promise_root_or_current, *p_promise_current = promise_continuation.p_promise_continuation; p_promise_current != nullptr) // non-root
                 {
                     p_promise_root->p_promise_root_or_current = p_promise_current; // adjust root's std::addressof(active_frame's promise)
+                    --p_promise_root->active_depth;
+                    p_promise_current->p_promise_root_or_current = p_promise_root; // the caller(parent) becomes the active frame (if the caller(parent) is root, this is the same assignment as above)
                     return std::coroutine_handle<generator_promise_base_t>::from_promise(*p_promise_current); // !!! not using the original promise but its base subobject to create std::coroutine_handle
                 }
                 else // root
@@ -83,13 +109,18 @@ namespace ext
 
         std::suspend_always yield_value(yielded_t yielded) noexcept
         {
-            this->p_yielded = std::addressof(yielded);
+            this->p_yielded = this->p_yielded_last = std::addressof(yielded);
             return {};
         }
-        template<typename reference_other_t, typename value_other_t, typename yielded_other_t>
+        std::suspend_never yield_value(generator_size_hint_t size_hint_) noexcept
+        {
+            size_hint = size_hint_.size;
+            return {};
+        }
+        template<typename reference_other_t, typename value_other_t, typename yielded_other_t, typename traits_other_t>
         struct yield_awaitable_t
         {
-            generator_t<reference_other_t, value_other_t, yielded_other_t> generator;
+            generator_t<reference_other_t, value_other_t, yielded_other_t, traits_other_t> generator;
             std::exception_ptr p_exception;
             bool await_ready() const noexcept { return generator.handle.done(); }
             template<std::derived_from<generator_promise_base_t> promise_type>
@@ -98,35 +129,168 @@ namespace ext
                 auto &promise_generator = generator.handle.promise();
                 assert(promise_generator.p_promise_continuation == nullptr); // assert(subtree.p_root->p_parent == nullptr)
                 promise_type *p_promise_continuation = std::addressof(continuation.promise());
-                promise_generator.p_promise_continuation = p_promise_continuation; // subtree.p_root->p_parent = tree.p_leaf
                 generator_promise_base_t *p_promise_continuation_root = p_promise_continuation->p_promise_continuation == nullptr ? p_promise_continuation : p_promise_continuation->p_promise_root_or_current;
-                p_promise_continuation_root->p_promise_root_or_current = promise_generator.p_promise_root_or_current; // tree.p_leaf = subtree.p_leaf
-                for (generator_promise_base_t *p_promise = promise_generator.p_promise_root_or_current; p_promise != p_promise_continuation; p_promise = p_promise->p_promise_continuation) // for (p = subtree.p_leaf; p != old tree.p_leaf; p = p->p_parent)
-                    p_promise->p_promise_root_or_current = p_promise_continuation_root;
+                if constexpr (promise_type::traits_t::spawns_in_parallel)
+                    if (parallel_spawner_t *p_parallel_spawner = p_promise_continuation_root->p_parallel_spawner; p_parallel_spawner != nullptr)
+                    {
+                        promise_generator.p_parallel_spawner = p_parallel_spawner; // the subtree's own grafts are spawned too
+                        if (p_parallel_spawner->spawn(*p_parallel_spawner, generator.handle))
+                        {
+                            generator.handle = nullptr;
+                            return continuation; // the subtree is consumed elsewhere, carry on with the caller(parent)
+                        }
+                        promise_generator.p_parallel_spawner = nullptr;
+                    }
+                promise_generator.p_promise_continuation = p_promise_continuation; // subtree.p_root->p_parent = tree.p_leaf
+                generator_promise_base_t *p_promise_generator_current = promise_generator.p_promise_root_or_current;
+                p_promise_continuation_root->p_promise_root_or_current = p_promise_generator_current; // tree.p_leaf = subtree.p_leaf
+                p_promise_generator_current->p_promise_root_or_current = p_promise_continuation_root; // subtree.p_leaf->p_root = tree.p_root, the rest of the subtree is not visited
+                p_promise_continuation_root->active_depth += 1uz + promise_generator.active_depth;
                 promise_generator.p_p_exception = &p_exception;
+                promise_generator.p_handle_owner = &generator.handle;
+                promise_type::hooks_t::on_graft(p_promise_continuation_root->active_depth);
+                if (p_promise_generator_current->p_yielded == nullptr) // the subtree is lazy and has not started, run it up to its first co_yield
+                    return std::coroutine_handle<generator_promise_base_t>::from_promise(*p_promise_generator_current);
                 return std::noop_coroutine();
             }
-            void await_resume() noexcept
+            void await_resume() // Not noexcept: rethrows the exception that escaped the subtree, as if co_yield std::ranges::elements_of(generator) had thrown it.
             {
                 if (p_exception)
                     std::rethrow_exception(std::move(p_exception));
             }
         };
-        template<typename reference_other_t, typename value_other_t, typename yielded_other_t, typename allocator_t> requires std::same_as<typename generator_t<reference_other_t, value_other_t, yielded_other_t>::yielded_t, yielded_t>
-        auto yield_value(std::ranges::elements_of<generator_t<reference_other_t, value_other_t, yielded_other_t> &&, allocator_t> generator_and_allocator) const noexcept
+        template<typename reference_other_t, typename value_other_t, typename yielded_other_t, typename traits_other_t, typename allocator_t> requires std::same_as<typename generator_t<reference_other_t, value_other_t, yielded_other_t, traits_other_t>::yielded_t, yielded_t>
+        auto yield_value(std::ranges::elements_of<generator_t<reference_other_t, value_other_t, yielded_other_t, traits_other_t> &&, allocator_t> generator_and_allocator) const noexcept
         {
             assert(generator_and_allocator.range.joinable());
-            return yield_awaitable_t<reference_other_t, value_other_t, yielded_other_t>{.generator = std::move(generator_and_allocator.range)};
+            return yield_awaitable_t<reference_other_t, value_other_t, yielded_other_t, traits_other_t>{.generator = std::move(generator_and_allocator.range)};
         }
+        template<typename range_t>
+        struct yield_range_awaitable_t : public range_cursor_t // Iterates the range in place: iterator_t::operator++ advances i (or p_yielded for contiguous ranges) instead of resuming a coroutine.
+        {
+            using range_iterator_t = std::ranges::iterator_t<range_t>;
+            using range_sentinel_t = std::ranges::sentinel_t<range_t>;
+            using range_reference_t = std::ranges::range_reference_t<range_t>;
+            static constexpr bool reference_binds_directly = std::is_reference_v<range_reference_t> && std::is_convertible_v<std::add_pointer_t<range_reference_t>, std::add_pointer_t<yielded_t>>; // static_cast<yielded_t>(*i) does not materialize a temporary
+            static constexpr bool is_contiguous = reference_binds_directly && std::is_same_v<std::remove_cvref_t<range_reference_t>, std::remove_cvref_t<yielded_t>> && std::contiguous_iterator<range_iterator_t> && std::sized_sentinel_for<range_sentinel_t, range_iterator_t>; // [p_yielded, p_yielded_last] can step through the range
+            using materialized_t = std::conditional_t<std::is_convertible_v<std::add_pointer_t<std::remove_reference_t<range_reference_t>>, std::add_pointer_t<yielded_t>>, std::remove_cvref_t<range_reference_t>, std::remove_cvref_t<yielded_t>>;
+
+            range_t range; // Owns the range if range_t is not a reference type, so that i and s do not dangle while suspended.
+            range_iterator_t i;
+            range_sentinel_t s;
+            [[no_unique_address]] std::conditional_t<reference_binds_directly, std::tuple<>, std::optional<materialized_t>> materialized; // Temporary that yielded_t binds to, if *i is not bound directly.
+            std::exception_ptr p_exception;
+
+            yield_range_awaitable_t(range_t &&range) : range_cursor_t{.advance = &yield_range_awaitable_t::advance, .size = &yield_range_awaitable_t::size, .advanced = 0uz}, range(std::forward<range_t>(range)), i(std::ranges::begin(this->range)), s(std::ranges::end(this->range)) {}
+            yield_range_awaitable_t(yield_range_awaitable_t const &) = delete;
+            yield_range_awaitable_t &operator=(yield_range_awaitable_t const &) = delete;
+
+            std::add_pointer_t<yielded_t> get_p_yielded()
+            {
+                if constexpr (reference_binds_directly)
+                {
+                    yielded_t yielded = static_cast<yielded_t>(*i);
+                    return std::addressof(yielded);
+                }
+                else
+                {
+                    yielded_t yielded = static_cast<yielded_t>(materialized.emplace(*i));
+                    return std::addressof(yielded);
+                }
+            }
+            static bool advance(range_cursor_t &range_cursor, generator_promise_base_t &promise) noexcept
+            {
+                yield_range_awaitable_t &awaitable = static_cast<yield_range_awaitable_t &>(range_cursor);
+                if constexpr (is_contiguous) // [p_yielded, p_yielded_last] has been stepped through
+                {
+                    promise.p_range_cursor = nullptr;
+                    return false;
+                }
+                try
+                {
+                    if (++awaitable.i != awaitable.s)
+                    {
+                        promise.p_yielded = promise.p_yielded_last = awaitable.get_p_yielded();
+                        ++awaitable.advanced;
+                        return true;
+                    }
+                }
+                catch (...)
+                {
+                    awaitable.p_exception = std::current_exception(); // rethrown by await_resume() inside the coroutine, as if co_yield std::ranges::elements_of(range) had thrown
+                }
+                promise.p_range_cursor = nullptr;
+                return false;
+            }
+            static std::size_t size(range_cursor_t const &range_cursor, generator_promise_base_t const &promise) noexcept
+            {
+                yield_range_awaitable_t const &awaitable = static_cast<yield_range_awaitable_t const &>(range_cursor);
+                if constexpr (is_contiguous)
+                    return static_cast<std::size_t>(promise.p_yielded_last - promise.p_yielded) + 1uz;
+                else if constexpr (std::sized_sentinel_for<range_sentinel_t, range_iterator_t>)
+                    return static_cast<std::size_t>(awaitable.s - awaitable.i);
+                else
+                    return 0uz;
+            }
+
+            bool await_ready() { return i == s; }
+            template<std::derived_from<generator_promise_base_t> promise_type>
+            void await_suspend(std::coroutine_handle<promise_type> continuation)
+            {
+                generator_promise_base_t &promise = continuation.promise();
+                if constexpr (is_contiguous)
+                {
+                    promise.p_yielded = std::to_address(i);
+                    promise.p_yielded_last = promise.p_yielded + (s - i - 1);
+                    this->advanced = static_cast<std::size_t>(s - i - 1); // stepped through by iterator_t::operator++() instead, counted in advance
+                }
+                else
+                    promise.p_yielded = promise.p_yielded_last = get_p_yielded();
+                promise.p_range_cursor = this;
+            }
+            void await_resume()
+            {
+                if (p_exception)
+                    std::rethrow_exception(std::move(p_exception));
+            }
+        };
         template<std::ranges::input_range range_t, typename allocator_t> requires std::convertible_to<std::ranges::range_reference_t<range_t>, yielded_t>
         auto yield_value(std::ranges::elements_of<range_t, allocator_t> range_and_allocator) const
         {
-            return generator_promise_base_t::yield_value(std::ranges::elements_of([](std::allocator_arg_t, decltype(range_and_allocator.allocator), std::ranges::iterator_t<range_t> i, std::ranges::sentinel_t<range_t> s) -> generator_t<yielded_t> {
-                for (; i != s; ++i)
-                    co_yield static_cast<yielded_t>(*i);
-            }(std::allocator_arg, static_cast<decltype(range_and_allocator.allocator) &&>(range_and_allocator.allocator), std::ranges::begin(range_and_allocator.range), std::ranges::end(range_and_allocator.range))));
+            return yield_range_awaitable_t<range_t>(std::forward<range_t>(range_and_allocator.range));
+        }
+    };
+
+    template<typename yielded_t>
+    struct generator_promise_caching_base_t : public generator_promise_base_t<yielded_t> // The promise base of generators whose traits_t::caches_value is true.
+    {
+        using stored_t = std::remove_cvref_t<yielded_t>;
+        std::optional<stored_t> stored; // What p_yielded points to after co_yield expression unless expression is an lvalue that yielded_t binds to directly. Constructed on the first such co_yield and assigned by the following ones, so its resources are reused.
+
+        using generator_promise_base_t<yielded_t>::yield_value;
+        template<typename expression_t> requires std::constructible_from<stored_t, expression_t>
+        std::suspend_always yield_value(expression_t &&expression) noexcept(std::is_nothrow_constructible_v<stored_t, expression_t> && (!std::is_assignable_v<stored_t &, expression_t> || std::is_nothrow_assignable_v<stored_t &, expression_t>))
+        {
+            if constexpr (std::is_lvalue_reference_v<yielded_t> && std::is_lvalue_reference_v<expression_t> && std::is_convertible_v<std::add_pointer_t<std::remove_reference_t<expression_t>>, std::add_pointer_t<yielded_t>>)
+                this->p_yielded = this->p_yielded_last = std::addressof(expression); // outlives the suspension, no need to store it
+            else
+            {
+                if constexpr (std::is_assignable_v<stored_t &, expression_t>)
+                {
+                    if (stored.has_value())
+                        *stored = std::forward<expression_t>(expression);
+                    else
+                        stored.emplace(std::forward<expression_t>(expression));
+                }
+                else
+                    stored.emplace(std::forward<expression_t>(expression));
+                this->p_yielded = this->p_yielded_last = std::addressof(*stored);
+            }
+            return {};
         }
     };
+    template<typename yielded_t, typename traits_t>
+    using generator_promise_base_for_t = std::conditional_t<traits_t::caches_value, generator_promise_caching_base_t<yielded_t>, generator_promise_base_t<yielded_t>>;
 
     template<type_agnostic_allocator_c allocator_t>
     struct generator_promise_needs_to_store_allocator : public std::bool_constant<!(std::allocator_traits<allocator_t>::template rebind_traits<std::byte>::is_always_equal::value && std::is_trivially_default_constructible_v<typename std::allocator_traits<allocator_t>::template rebind_alloc<std::byte>>)>
@@ -134,10 +298,10 @@ namespace ext
     template<type_agnostic_allocator_c allocator_t>
     inline constexpr bool generator_promise_needs_to_store_allocator_v = generator_promise_needs_to_store_allocator<allocator_t>::value;
 
-    template<type_agnostic_allocator_c allocator_t, bool allocator_is_given_explicitly>
+    template<type_agnostic_allocator_c allocator_t, bool allocator_is_given_explicitly, typename hooks_t>
     struct generator_promise_base_memory_t;
-    template<type_agnostic_allocator_c allocator_t, bool allocator_is_given_explicitly> requires generator_promise_needs_to_store_allocator_v<allocator_t>
-    struct generator_promise_base_memory_t<allocator_t, allocator_is_given_explicitly>
+    template<type_agnostic_allocator_c allocator_t, bool allocator_is_given_explicitly, typename hooks_t> requires generator_promise_needs_to_store_allocator_v<allocator_t>
+    struct generator_promise_base_memory_t<allocator_t, allocator_is_given_explicitly, hooks_t>
     {
         using allocator_traits_byte_t = std::allocator_traits<allocator_t>::template rebind_traits<std::byte>;
         using allocator_byte_t = allocator_traits_byte_t::allocator_type;
@@ -153,61 +317,161 @@ namespace ext
         template<typename... args_t> requires (!allocator_is_given_explicitly)
         static void *operator new(std::size_t frame_size, args_t &&...)
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_t = " << type_name<allocator_t>() << ", frame_size = " << frame_size << std::endl);
             allocator_byte_t allocator_byte;
             std::byte *p_frame = std::to_address(allocator_traits_byte_t::allocate(allocator_byte, padded_frame_size(frame_size)));
             allocator_traits_byte_t::construct(allocator_byte, get_p_allocator_byte(p_frame, frame_size), allocator_byte); // ::new (static_cast<void *>(get_p_allocator_byte(p_frame, frame_size))) allocator_byte_t(std::move(allocator_byte));
+            hooks_t::on_frame_allocate(frame_size);
             return p_frame;
         }
 
         template<typename allocator_t_, typename... args_t> requires allocator_is_given_explicitly
         static void *operator new(std::size_t frame_size, std::allocator_arg_t, allocator_t_ &&allocator, args_t &&...)
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_t = " << type_name<allocator_t>() << ", allocator_t_ = " << type_name<allocator_t_>() << ", frame_size = " << frame_size << std::endl);
             allocator_byte_t allocator_byte(std::forward<allocator_t_>(allocator));
             std::byte *p_frame = std::to_address(allocator_traits_byte_t::allocate(allocator_byte, padded_frame_size(frame_size)));
             allocator_traits_byte_t::construct(allocator_byte, get_p_allocator_byte(p_frame, frame_size), allocator_byte); // ::new (static_cast<void *>(get_p_allocator_byte(p_frame, frame_size))) allocator_byte_t(std::move(allocator_byte));
+            hooks_t::on_frame_allocate(frame_size);
             return p_frame;
         }
 
         template<typename this_t, typename allocator_t_, typename... args_t> requires allocator_is_given_explicitly
         static void *operator new(std::size_t frame_size, this_t &&, std::allocator_arg_t, allocator_t_ &&allocator, args_t &&...args)
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_t = " << type_name<allocator_t>() << ", allocator_t_ = " << type_name<allocator_t_>() << ", frame_size = " << frame_size << std::endl);
             return generator_promise_base_memory_t::operator new(frame_size, std::allocator_arg, std::forward<allocator_t_>(allocator), std::forward<args_t>(args)...);
         }
 
         static void operator delete(void *p_frame, std::size_t frame_size) noexcept
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_t = " << type_name<allocator_t>() << ", frame_size = " << frame_size << std::endl);
+            hooks_t::on_frame_deallocate(frame_size);
             allocator_byte_t &allocator_byte_ = *get_p_allocator_byte(static_cast<std::byte *>(p_frame), frame_size), allocator_byte(std::move(allocator_byte_));
             allocator_traits_byte_t::destroy(allocator_byte, std::addressof(allocator_byte_)); // allocator_byte_.~allocator_byte_t();
             allocator_traits_byte_t::deallocate(allocator_byte, pointer_traits_byte_t::pointer_to(*static_cast<std::byte *>(p_frame)), padded_frame_size(frame_size));
         }
     };
-    template<type_agnostic_allocator_c allocator_t, bool allocator_is_given_explicitly> requires (!generator_promise_needs_to_store_allocator_v<allocator_t>)
-    struct generator_promise_base_memory_t<allocator_t, allocator_is_given_explicitly>
+    template<type_agnostic_allocator_c allocator_t, bool allocator_is_given_explicitly, typename hooks_t> requires (!generator_promise_needs_to_store_allocator_v<allocator_t>)
+    struct generator_promise_base_memory_t<allocator_t, allocator_is_given_explicitly, hooks_t>
     {
         using allocator_traits_byte_t = std::allocator_traits<allocator_t>::template rebind_traits<std::byte>;
         using allocator_byte_t = allocator_traits_byte_t::allocator_type;
         using pointer_traits_byte_t = std::pointer_traits<typename allocator_traits_byte_t::pointer>;
         static void *operator new(std::size_t frame_size)
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_t = " << type_name<allocator_t>() << ", frame_size = " << frame_size << std::endl);
             allocator_byte_t allocator_byte;
-            return std::to_address(allocator_traits_byte_t::allocate(allocator_byte, frame_size));
+            void *p_frame = std::to_address(allocator_traits_byte_t::allocate(allocator_byte, frame_size));
+            hooks_t::on_frame_allocate(frame_size);
+            return p_frame;
         }
         static void operator delete(void *p_frame, std::size_t frame_size) noexcept
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_t = " << type_name<allocator_t>() << ", frame_size = " << frame_size << std::endl);
+            hooks_t::on_frame_deallocate(frame_size);
             allocator_byte_t allocator_byte;
             allocator_traits_byte_t::deallocate(allocator_byte, pointer_traits_byte_t::pointer_to(*static_cast<std::byte *>(p_frame)), frame_size);
         }
     };
 
-    template<typename reference_t_, typename value_t_, typename yielded_t_> requires (std::is_void_v<yielded_t_> || std::is_reference_v<yielded_t_>)
-    struct generator_t : public std::ranges::view_interface<generator_t<reference_t_, value_t_, yielded_t_>> // https://github.com/cor3ntin/coro_benchmark/blob/main/generator.hpp
+    struct generator_frame_pool_t // Recycles coroutine frames by size class. Cached blocks are plain ::operator new blocks of their size class's size, so a block can be returned to any pool (or to ::operator delete), e.g. when a frame is destroyed on another thread. Not thread-safe: use one pool per thread.
+    {
+        static constexpr std::size_t size_class_granularity = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+        static constexpr std::size_t size_class_count = 64uz; // frames larger than size_class_count * size_class_granularity bytes are not recycled
+        static constexpr std::size_t size_class_index(std::size_t frame_size) noexcept { return (frame_size - 1uz) / size_class_granularity; }
+        static constexpr std::size_t block_size(std::size_t frame_size) noexcept { return size_class_index(frame_size) < size_class_count ? (size_class_index(frame_size) + 1uz) * size_class_granularity : frame_size; }
+
+        struct free_block_t
+        {
+            free_block_t *p_next;
+        };
+        free_block_t *p_free_blocks[size_class_count] = {};
+
+        generator_frame_pool_t() noexcept = default;
+        generator_frame_pool_t(generator_frame_pool_t const &) = delete;
+        generator_frame_pool_t &operator=(generator_frame_pool_t const &) = delete;
+        ~generator_frame_pool_t()
+        {
+            assert(p_thread_local != this);
+            release();
+        }
+
+        void *allocate(std::size_t frame_size)
+        {
+            assert(frame_size != 0uz);
+            if (std::size_t index = size_class_index(frame_size); index < size_class_count && p_free_blocks[index] != nullptr)
+                return std::exchange(p_free_blocks[index], p_free_blocks[index]->p_next);
+            return ::operator new(block_size(frame_size));
+        }
+        void deallocate(void *p_frame, std::size_t frame_size) noexcept
+        {
+            if (std::size_t index = size_class_index(frame_size); index < size_class_count)
+                p_free_blocks[index] = ::new (p_frame) free_block_t{.p_next = p_free_blocks[index]};
+            else
+                ::operator delete(p_frame, block_size(frame_size));
+        }
+        void release() noexcept // Returns all cached blocks to ::operator delete.
+        {
+            for (std::size_t index = 0uz; index != size_class_count; ++index)
+                while (p_free_blocks[index] != nullptr)
+                    ::operator delete(std::exchange(p_free_blocks[index], p_free_blocks[index]->p_next), (index + 1uz) * size_class_granularity);
+        }
+
+        inline static thread_local generator_frame_pool_t *p_thread_local = nullptr; // Used by generator_frame_pool_thread_local_allocator_t, which is the allocator of generators that are not given one explicitly.
+        static generator_frame_pool_t *exchange_thread_local(generator_frame_pool_t *p_pool) noexcept { return std::exchange(p_thread_local, p_pool); }
+        struct thread_local_scope_t // Installs a pool as the thread-local pool for the lifetime of the scope.
+        {
+            generator_frame_pool_t *p_pool_previous;
+            explicit thread_local_scope_t(generator_frame_pool_t &pool) noexcept : p_pool_previous(exchange_thread_local(std::addressof(pool))) {}
+            thread_local_scope_t(thread_local_scope_t const &) = delete;
+            thread_local_scope_t &operator=(thread_local_scope_t const &) = delete;
+            ~thread_local_scope_t() { exchange_thread_local(p_pool_previous); }
+        };
+        static void *allocate_thread_local(std::size_t frame_size) { return p_thread_local != nullptr ? p_thread_local->allocate(frame_size) : ::operator new(block_size(frame_size)); }
+        static void deallocate_thread_local(void *p_frame, std::size_t frame_size) noexcept
+        {
+            if (p_thread_local != nullptr)
+                p_thread_local->deallocate(p_frame, frame_size);
+            else
+                ::operator delete(p_frame, block_size(frame_size));
+        }
+    };
+
+    template<typename value_t>
+    struct generator_frame_pool_allocator_t // Allocates from a given pool; pass it with std::allocator_arg. The coroutine state keeps the pool and deallocates into it, so the pool is used from whichever thread resumes or destroys the generator.
+    {
+        using value_type = value_t;
+        generator_frame_pool_t *p_pool;
+        generator_frame_pool_allocator_t(generator_frame_pool_t &pool) noexcept : p_pool(std::addressof(pool)) {}
+        template<typename value_other_t>
+        generator_frame_pool_allocator_t(generator_frame_pool_allocator_t<value_other_t> const &other) noexcept : p_pool(other.p_pool) {}
+        value_t *allocate(std::size_t n)
+        {
+            static_assert(alignof(value_t) <= generator_frame_pool_t::size_class_granularity);
+            return static_cast<value_t *>(p_pool->allocate(n * sizeof(value_t)));
+        }
+        void deallocate(value_t *p, std::size_t n) noexcept { p_pool->deallocate(p, n * sizeof(value_t)); }
+        template<typename value_other_t>
+        friend bool operator==(generator_frame_pool_allocator_t const &lhs, generator_frame_pool_allocator_t<value_other_t> const &rhs) noexcept { return lhs.p_pool == rhs.p_pool; }
+    };
+
+    template<typename value_t>
+    struct generator_frame_pool_thread_local_allocator_t // Allocates from generator_frame_pool_t::p_thread_local if one is installed, otherwise from ::operator new. Stateless, so it is not stored in the coroutine state.
+    {
+        using value_type = value_t;
+        using is_always_equal = std::true_type;
+        generator_frame_pool_thread_local_allocator_t() noexcept = default;
+        template<typename value_other_t>
+        generator_frame_pool_thread_local_allocator_t(generator_frame_pool_thread_local_allocator_t<value_other_t> const &) noexcept {}
+        value_t *allocate(std::size_t n)
+        {
+            static_assert(alignof(value_t) <= generator_frame_pool_t::size_class_granularity);
+            return static_cast<value_t *>(generator_frame_pool_t::allocate_thread_local(n * sizeof(value_t)));
+        }
+        void deallocate(value_t *p, std::size_t n) noexcept { generator_frame_pool_t::deallocate_thread_local(p, n * sizeof(value_t)); }
+        template<typename value_other_t>
+        friend bool operator==(generator_frame_pool_thread_local_allocator_t const &, generator_frame_pool_thread_local_allocator_t<value_other_t> const &) noexcept { return true; }
+    };
+
+    template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_> requires (std::is_void_v<yielded_t_> || std::is_reference_v<yielded_t_>)
+    struct generator_t : public std::ranges::view_interface<generator_t<reference_t_, value_t_, yielded_t_, traits_t_>> // https://github.com/cor3ntin/coro_benchmark/blob/main/generator.hpp
     {
+        using traits_t = traits_t_;
         using value_t = std::conditional_t<std::is_void_v<value_t_>, std::remove_cvref_t<reference_t_>, value_t_>;
         using reference_t = std::conditional_t<std::is_void_v<value_t_>, reference_t_ &&, reference_t_>;
         using yielded_t = std::conditional_t<std::is_void_v<yielded_t_>, std::conditional_t<std::is_reference_v<reference_t>, reference_t, reference_t const &>, yielded_t_>;
@@ -225,7 +489,7 @@ namespace ext
             if (this != std::addressof(other))
             {
                 if (joinable())
-                    handle.destroy();
+                    destroy(handle);
                 handle = std::exchange(other.handle, nullptr);
             }
             return *this;
@@ -233,12 +497,36 @@ namespace ext
         ~generator_t()
         {
             if (joinable())
-                handle.destroy();
+                destroy(handle);
+        }
+        static void destroy(std::coroutine_handle<promise_t> handle) noexcept // Destroys the coroutine states of a tree without recursion: from the active frame up to the root, each frame is detached from the caller(parent)'s yield_awaitable_t before it is destroyed, so destroying the caller(parent) does not destroy it again. This is the order recursive destruction would have (a frame's subtree is destroyed before its own locals), in O(depth) time and O(1) stack.
+        {
+            promise_t &promise_root = handle.promise();
+            if (promise_root.p_promise_continuation == nullptr) // root (a non-root handle is only destroyed when its caller(parent) awaitable completes, after it is done)
+                for (promise_t *p_promise_current = promise_root.p_promise_root_or_current; p_promise_current != std::addressof(promise_root);)
+                {
+                    promise_t *p_promise_continuation = p_promise_current->p_promise_continuation;
+                    *p_promise_current->p_handle_owner = nullptr;
+                    std::coroutine_handle<promise_t>::from_promise(*p_promise_current).destroy();
+                    p_promise_current = p_promise_continuation;
+                }
+            handle.destroy();
         }
 
-        bool empty() const noexcept
+        void start() const noexcept(!traits_t::lazy) // Runs a lazy generator's coroutine body up to its first co_yield, unless it has started.
+        {
+            assert(joinable());
+            if constexpr (traits_t::lazy)
+                if (!handle.done() && handle.promise().p_promise_root_or_current->p_yielded == nullptr)
+                {
+                    traits_t::hooks_t::on_resume();
+                    handle.resume();
+                }
+        }
+        bool empty() const noexcept(!traits_t::lazy)
         {
             assert(joinable());
+            start();
             return handle.done();
         }
         struct iterator_t
@@ -249,7 +537,17 @@ namespace ext
             iterator_t &operator++()
             {
                 assert(!is_end());
-                std::coroutine_handle<promise_t>::from_promise(*handle.promise().p_promise_root_or_current).resume();
+                traits_t::hooks_t::on_advance();
+                promise_t &promise_current = *handle.promise().p_promise_root_or_current;
+                if (promise_current.p_yielded != promise_current.p_yielded_last) // co_yield std::ranges::elements_of(contiguous range)
+                    ++promise_current.p_yielded;
+                else if (typename promise_t::range_cursor_t *p_range_cursor = promise_current.p_range_cursor; p_range_cursor == nullptr || !p_range_cursor->advance(*p_range_cursor, promise_current))
+                {
+                    if (promise_t &promise_root = handle.promise(); promise_root.size_hint != 0uz) // count the elements consumed since the coroutine suspended off the declared size hint, once per resumption rather than per element, and before resuming (which may declare a new one)
+                        promise_root.size_hint -= std::min(promise_root.size_hint, 1uz + (p_range_cursor != nullptr ? p_range_cursor->advanced : 0uz));
+                    traits_t::hooks_t::on_resume();
+                    std::coroutine_handle<promise_t>::from_promise(promise_current).resume();
+                }
                 return *this;
             }
             void operator++(int) { operator++(); }
@@ -270,9 +568,10 @@ namespace ext
             }
             friend bool operator==(iterator_t const &iterator, std::default_sentinel_t const &) noexcept { return iterator.is_end(); }
         };
-        iterator_t begin() noexcept
+        iterator_t begin() noexcept(!traits_t::lazy)
         {
             assert(joinable());
+            start();
             return iterator_t{.handle = handle};
         }
         std::default_sentinel_t end() const noexcept
@@ -280,42 +579,122 @@ namespace ext
             assert(joinable());
             return {};
         }
-    };
-} // namespace ext
 
+        using chunk_t = std::span<std::remove_reference_t<yielded_t>>;
+        struct chunk_iterator_t // Iterates [p_yielded, p_yielded_last] of the innermost coroutine as a whole: a chunk is the rest of a contiguous range during co_yield std::ranges::elements_of(contiguous range), otherwise a single element.
+        {
+            std::coroutine_handle<promise_t> handle = nullptr;
 
-template<typename reference_t_, typename value_t_, typename yielded_t_, typename... args_t>
-struct std::coroutine_traits<ext::generator_t<reference_t_, value_t_, yielded_t_>, args_t...>
-{
-    struct promise_type : public ext::generator_promise_base_t<typename ext::generator_t<reference_t_, value_t_, yielded_t_>::yielded_t>, public ext::generator_promise_base_memory_t<std::allocator<void>, false>
-    {
-        ext::generator_t<reference_t_, value_t_, yielded_t_> get_return_object() noexcept
+            using difference_type = std::ptrdiff_t;
+            chunk_iterator_t &operator++()
+            {
+                assert(!is_end());
+                promise_t &promise_current = *handle.promise().p_promise_root_or_current;
+                promise_current.p_yielded = promise_current.p_yielded_last; // the rest of the chunk is consumed
+                ++iterator_t{.handle = handle};
+                return *this;
+            }
+            void operator++(int) { operator++(); }
+
+            using value_type = chunk_t;
+            chunk_t operator*() const
+            {
+                assert(!is_end());
+                promise_t &promise_current = *handle.promise().p_promise_root_or_current;
+                return chunk_t(promise_current.p_yielded, promise_current.p_yielded_last + 1);
+            }
+
+            using iterator_concept = std::input_iterator_tag;
+
+            bool is_end() const noexcept { return iterator_t{.handle = handle}.is_end(); }
+            friend bool operator==(chunk_iterator_t const &iterator, std::default_sentinel_t const &) noexcept { return iterator.is_end(); }
+        };
+        std::ranges::subrange<chunk_iterator_t, std::default_sentinel_t> chunks() noexcept(!traits_t::lazy)
         {
-            return {std::coroutine_handle<typename ext::generator_t<reference_t_, value_t_, yielded_t_>::promise_t>::from_promise(*this)}; // !!! not using the original promise but its base subobject to create std::coroutine_handle
+            assert(joinable());
+            start();
+            return {chunk_iterator_t{.handle = handle}, std::default_sentinel};
         }
-    };
-};
-template<typename reference_t_, typename value_t_, typename yielded_t_, typename allocator_cvref_t, typename... args_t>
-struct std::coroutine_traits<ext::generator_t<reference_t_, value_t_, yielded_t_>, std::allocator_arg_t, allocator_cvref_t, args_t...>
-{
-    struct promise_type : public ext::generator_promise_base_t<typename ext::generator_t<reference_t_, value_t_, yielded_t_>::yielded_t>, public ext::generator_promise_base_memory_t<typename std::allocator_traits<std::remove_cvref_t<allocator_cvref_t>>::template rebind_alloc<void>, true>
-    {
-        ext::generator_t<reference_t_, value_t_, yielded_t_> get_return_object() noexcept
+
+        std::size_t size_hint() const noexcept(!traits_t::lazy) // The number of elements the root coroutine declared it would produce (see generator_size_hint_t), less those consumed since. If it declared none (or they have all been consumed), the number of elements left in the range it is producing with co_yield std::ranges::elements_of(range), if the range can tell. 0 if unknown or done.
+        {
+            assert(joinable());
+            start();
+            if (handle.done())
+                return 0uz;
+            promise_t &promise = handle.promise(), &promise_current = *promise.p_promise_root_or_current;
+            if (std::size_t consumed = promise_current.p_range_cursor != nullptr ? promise_current.p_range_cursor->advanced - static_cast<std::size_t>(promise_current.p_yielded_last - promise_current.p_yielded) : 0uz; promise.size_hint > consumed) // consumed since the coroutine suspended, not counted off yet
+                return promise.size_hint - consumed;
+            if (promise.p_promise_root_or_current == std::addressof(promise) && promise.p_range_cursor != nullptr) // no subtree is grafted
+                return promise.p_range_cursor->size(*promise.p_range_cursor, promise);
+            return 0uz;
+        }
+        template<typename container_t> requires requires(container_t &container, reference_t reference) { container.push_back(static_cast<reference_t>(reference)); }
+        container_t &drain_into(container_t &container) // Appends the rest of the elements to container: reserves for size_hint() if container has reserve(), inserts each contiguous chunk with a single insert(end(), first, last) and the other elements with push_back().
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_cvref_t = " << ext::type_name<allocator_cvref_t>() << std::endl);
-            return {std::coroutine_handle<typename ext::generator_t<reference_t_, value_t_, yielded_t_>::promise_t>::from_promise(*this)}; // !!! not using the original promise but its base subobject to create std::coroutine_handle
+            assert(joinable());
+            start();
+            if constexpr (requires { container.reserve(container.capacity()); })
+                if (std::size_t size_required = container.size() + size_hint(); container.capacity() < size_required)
+                    container.reserve(std::max(size_required, container.capacity() * 2uz)); // keeps repeated drains amortized O(1) per element
+            for (chunk_iterator_t chunk_iterator{.handle = handle}; chunk_iterator != std::default_sentinel; ++chunk_iterator)
+            {
+                chunk_t chunk = *chunk_iterator;
+                if constexpr (std::is_reference_v<reference_t>) // static_cast<reference_t>(element) is the element itself, so it can be inserted from the span
+                {
+                    if (chunk.size() != 1uz)
+                    {
+                        if constexpr (std::is_rvalue_reference_v<reference_t> && requires { container.insert(container.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end())); })
+                        {
+                            container.insert(container.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+                            continue;
+                        }
+                        else if constexpr (!std::is_rvalue_reference_v<reference_t> && requires { container.insert(container.end(), chunk.begin(), chunk.end()); })
+                        {
+                            container.insert(container.end(), chunk.begin(), chunk.end());
+                            continue;
+                        }
+                    }
+                }
+                for (std::remove_reference_t<yielded_t> &element : chunk)
+                    container.push_back(static_cast<reference_t>(element));
+            }
+            return container;
         }
     };
-};
-template<typename reference_t_, typename value_t_, typename yielded_t_, typename this_cvref_t, typename allocator_cvref_t, typename... args_t>
-struct std::coroutine_traits<ext::generator_t<reference_t_, value_t_, yielded_t_>, this_cvref_t, std::allocator_arg_t, allocator_cvref_t, args_t...>
-{
-    struct promise_type : public ext::generator_promise_base_t<typename ext::generator_t<reference_t_, value_t_, yielded_t_>::yielded_t>, public ext::generator_promise_base_memory_t<typename std::allocator_traits<std::remove_cvref_t<allocator_cvref_t>>::template rebind_alloc<void>, true>
+
+    template<typename generator_t, typename memory_base_t>
+    struct generator_promise_t : public generator_promise_base_for_t<typename generator_t::yielded_t, typename generator_t::traits_t>, public memory_base_t // The actual promise of generator_t, selected by the std::coroutine_traits specializations below.
     {
-        ext::generator_t<reference_t_, value_t_, yielded_t_> get_return_object() noexcept
+        using traits_t = typename generator_t::traits_t;
+        using hooks_t = typename traits_t::hooks_t;
+
+        std::conditional_t<traits_t::lazy, std::suspend_always, std::suspend_never> initial_suspend() const noexcept { return {}; }
+        void unhandled_exception() const
         {
-            if_ext_generator_debug(std::cout << __func__ << ", " << __LINE__ << ", allocator_cvref_t = " << ext::type_name<allocator_cvref_t>() << std::endl);
-            return {std::coroutine_handle<typename ext::generator_t<reference_t_, value_t_, yielded_t_>::promise_t>::from_promise(*this)}; // !!! not using the original promise but its base subobject to create std::coroutine_handle
+            hooks_t::on_exception(this->p_p_exception != nullptr ? this->p_promise_root_or_current->active_depth : 0uz); // a non-root frame that throws is the active frame, so it knows the root
+            generator_promise_base_t<typename generator_t::yielded_t>::unhandled_exception();
+        }
+        generator_t get_return_object() noexcept
+        {
+            return {std::coroutine_handle<typename generator_t::promise_t>::from_promise(*this)}; // !!! not using the original promise but its base subobject to create std::coroutine_handle
         }
     };
+} // namespace ext
+
+
+template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_, typename... args_t>
+struct std::coroutine_traits<ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>, args_t...>
+{
+    using promise_type = ext::generator_promise_t<ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>, ext::generator_promise_base_memory_t<ext::generator_frame_pool_thread_local_allocator_t<void>, false, typename traits_t_::hooks_t>>;
+};
+template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_, typename allocator_cvref_t, typename... args_t>
+struct std::coroutine_traits<ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>, std::allocator_arg_t, allocator_cvref_t, args_t...>
+{
+    using promise_type = ext::generator_promise_t<ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>, ext::generator_promise_base_memory_t<typename std::allocator_traits<std::remove_cvref_t<allocator_cvref_t>>::template rebind_alloc<void>, true, typename traits_t_::hooks_t>>;
+};
+template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_, typename this_cvref_t, typename allocator_cvref_t, typename... args_t>
+struct std::coroutine_traits<ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>, this_cvref_t, std::allocator_arg_t, allocator_cvref_t, args_t...>
+{
+    using promise_type = ext::generator_promise_t<ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>, ext::generator_promise_base_memory_t<typename std::allocator_traits<std::remove_cvref_t<allocator_cvref_t>>::template rebind_alloc<void>, true, typename traits_t_::hooks_t>>;
 };
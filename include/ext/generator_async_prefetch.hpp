@@ -0,0 +1,203 @@
+#pragma once
+
+#include "generator.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <utility>
+
+namespace ext
+{
+    template<typename value_t>
+    struct spsc_ring_t // Bounded lock-free ring buffer for one producer thread and one consumer thread. Both sides block with std::atomic::wait when the ring is full or empty. The consumer hands freed slots back half a ring at a time, so a full ring wakes the producer once per batch instead of once per element.
+    {
+        static constexpr std::size_t cache_line_size = 64uz;
+        static constexpr std::size_t flag = 1uz; // Counters are stored as count << 1 | flag, so that closing (producer) or stopping (consumer) changes the word the other side waits on.
+
+        std::size_t mask;
+        std::unique_ptr<std::optional<value_t>[]> p_slots;
+        alignas(cache_line_size) std::atomic<std::size_t> tail_and_closed; // Written by the producer: number of pushed elements, closed flag.
+        std::atomic<bool> consumer_waiting; // Set by the consumer before it waits for tail_and_closed to change, cleared by the producer when it notifies, so that the producer does not notify on every push while the consumer is busy (or woken but not yet running).
+        std::size_t head_cached; // Producer's last observed head, reloaded only when the ring looks full.
+        alignas(cache_line_size) std::atomic<std::size_t> head_and_stopped; // Written by the consumer: number of popped elements (published in batches), stopped flag.
+        std::size_t head; // Consumer's number of popped elements, published to head_and_stopped when it is publish_batch ahead.
+        std::size_t tail_cached; // Consumer's last observed tail, reloaded only when the ring looks empty.
+        std::exception_ptr p_exception; // Written by the producer before closing, read by the consumer after observing the closed flag.
+
+        explicit spsc_ring_t(std::size_t capacity) : mask(std::bit_ceil(capacity == 0uz ? 1uz : capacity) - 1uz), p_slots(std::make_unique<std::optional<value_t>[]>(mask + 1uz)), tail_and_closed(0uz), consumer_waiting(false), head_cached(0uz), head_and_stopped(0uz), head(0uz), tail_cached(0uz) {}
+        spsc_ring_t(spsc_ring_t const &) = delete;
+        spsc_ring_t &operator=(spsc_ring_t const &) = delete;
+
+        // Producer side.
+        template<typename... args_t>
+        bool push(args_t &&...args) // Blocks while the ring is full. Returns false (without constructing) once it observes that the consumer has stopped, which it checks only when the ring looks full, so at most a ring's worth of elements is produced in vain.
+        {
+            std::size_t tail = tail_and_closed.load(std::memory_order_relaxed) >> 1;
+            while (tail - (head_cached >> 1) == mask + 1uz)
+            {
+                if ((head_cached & flag) != 0uz)
+                    return false;
+                std::size_t head_and_stopped_observed = head_and_stopped.load(std::memory_order_acquire);
+                if (head_and_stopped_observed == head_cached)
+                {
+                    head_and_stopped.wait(head_and_stopped_observed, std::memory_order_acquire);
+                    head_and_stopped_observed = head_and_stopped.load(std::memory_order_acquire);
+                }
+                head_cached = head_and_stopped_observed;
+            }
+            p_slots[tail & mask].emplace(std::forward<args_t>(args)...);
+            publish_tail((tail + 1uz) << 1);
+            return true;
+        }
+        void close(std::exception_ptr p_exception_) noexcept // No more elements. p_exception_ (if any) is rethrown by the consumer after the pushed elements.
+        {
+            p_exception = std::move(p_exception_);
+            publish_tail(tail_and_closed.load(std::memory_order_relaxed) | flag);
+        }
+        void publish_tail(std::size_t tail_and_closed_) noexcept
+        {
+            tail_and_closed.store(tail_and_closed_, std::memory_order_seq_cst); // seq_cst with the load below and the consumer's store to consumer_waiting and reload of tail_and_closed: either the consumer sees the new tail or the producer sees it waiting
+            if (consumer_waiting.load(std::memory_order_seq_cst) && consumer_waiting.exchange(false, std::memory_order_relaxed))
+                tail_and_closed.notify_one();
+        }
+
+        // Consumer side.
+        std::size_t publish_batch() const noexcept { return (mask + 2uz) / 2uz; }
+        value_t *front() // Blocks while the ring is empty and open, returns nullptr once it is closed and drained (rethrowing the producer's exception, if any).
+        {
+            while (head == tail_cached >> 1)
+            {
+                if ((tail_cached & flag) != 0uz)
+                {
+                    if (p_exception)
+                        std::rethrow_exception(std::exchange(p_exception, nullptr));
+                    return nullptr;
+                }
+                std::size_t tail_and_closed_observed = tail_and_closed.load(std::memory_order_acquire);
+                if (tail_and_closed_observed == tail_cached)
+                {
+                    consumer_waiting.store(true, std::memory_order_seq_cst);
+                    tail_and_closed_observed = tail_and_closed.load(std::memory_order_seq_cst);
+                    if (tail_and_closed_observed == tail_cached)
+                    {
+                        tail_and_closed.wait(tail_and_closed_observed, std::memory_order_acquire);
+                        tail_and_closed_observed = tail_and_closed.load(std::memory_order_acquire);
+                    }
+                }
+                tail_cached = tail_and_closed_observed;
+            }
+            return std::addressof(*p_slots[head & mask]);
+        }
+        void pop() noexcept // Precondition: front() != nullptr.
+        {
+            p_slots[head++ & mask].reset();
+            if (head - (head_and_stopped.load(std::memory_order_relaxed) >> 1) == publish_batch())
+            {
+                head_and_stopped.store(head << 1, std::memory_order_release);
+                head_and_stopped.notify_one();
+            }
+        }
+        void stop() noexcept // The consumer is not interested in more elements: wakes the producer, whose next push() returns false.
+        {
+            head_and_stopped.store(head << 1 | flag, std::memory_order_release);
+            head_and_stopped.notify_one();
+        }
+    };
+
+    template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_>
+    struct async_prefetch_t : public std::ranges::view_interface<async_prefetch_t<reference_t_, value_t_, yielded_t_, traits_t_>> // Runs a generator on a worker thread, which moves or copies its elements into a spsc_ring_t ahead of the consumer.
+    {
+        using generator_t = ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>;
+        using value_t = typename generator_t::value_t;
+
+        struct state_t
+        {
+            spsc_ring_t<value_t> ring;
+            value_t *p_front = nullptr; // The consumer's current element (in ring), nullptr before begin() and at the end.
+            std::thread thread; // Owns the generator: the coroutine states are resumed and destroyed on this thread.
+
+            state_t(generator_t &&generator, std::size_t capacity)
+                : ring(capacity), thread([](spsc_ring_t<value_t> &ring, generator_t generator) {
+                      std::exception_ptr p_exception;
+                      try
+                      {
+                          for (auto &&e : generator)
+                              if (!ring.push(std::forward<decltype(e)>(e)))
+                                  break;
+                      }
+                      catch (...)
+                      {
+                          p_exception = std::current_exception();
+                      }
+                      ring.close(std::move(p_exception));
+                  },
+                      std::ref(ring), std::move(generator))
+            {}
+            ~state_t()
+            {
+                ring.stop();
+                thread.join();
+            }
+        };
+        std::unique_ptr<state_t> p_state;
+
+        bool joinable() const noexcept { return p_state != nullptr; }
+        async_prefetch_t() noexcept = default;
+        async_prefetch_t(generator_t &&generator, std::size_t capacity) : p_state(std::make_unique<state_t>(std::move(generator), capacity)) {}
+
+        struct iterator_t
+        {
+            state_t *p_state = nullptr;
+
+            using difference_type = std::ptrdiff_t;
+            iterator_t &operator++() // Rethrows the generator's exception after its last element.
+            {
+                assert(!is_end());
+                p_state->ring.pop();
+                p_state->p_front = nullptr;
+                p_state->p_front = p_state->ring.front();
+                return *this;
+            }
+            void operator++(int) { operator++(); }
+
+            using value_type = value_t;
+            value_t &operator*() const noexcept
+            {
+                assert(!is_end());
+                return *p_state->p_front;
+            }
+
+            using iterator_concept = std::input_iterator_tag;
+
+            bool is_end() const noexcept { return p_state->p_front == nullptr; }
+            friend bool operator==(iterator_t const &iterator, std::default_sentinel_t const &) noexcept { return iterator.is_end(); }
+        };
+        iterator_t begin() // Waits for the first element. Rethrows the generator's exception if it has no elements.
+        {
+            assert(joinable());
+            if (p_state->p_front == nullptr)
+                p_state->p_front = p_state->ring.front();
+            return iterator_t{.p_state = p_state.get()};
+        }
+        std::default_sentinel_t end() const noexcept
+        {
+            assert(joinable());
+            return {};
+        }
+    };
+
+    // The worker thread resumes and destroys generator's coroutine states and creates its nested generators. Those allocated with the default allocator may be freed there (blocks of generator_frame_pool_t are interchangeable with ::operator new blocks), but a generator_frame_pool_allocator_t's pool is used by the worker thread until the async_prefetch_t is destroyed, so no other thread may use that pool meanwhile.
+    template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_>
+    async_prefetch_t<reference_t_, value_t_, yielded_t_, traits_t_> async_prefetch(generator_t<reference_t_, value_t_, yielded_t_, traits_t_> &&generator, std::size_t capacity)
+    {
+        assert(generator.joinable());
+        return {std::move(generator), capacity};
+    }
+} // namespace ext
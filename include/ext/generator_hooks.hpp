@@ -0,0 +1,78 @@
+#pragma once
+
+#include "generator.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ext
+{
+    struct generator_log2_histogram_t // Counts values by std::bit_width: bucket 0 counts 0, bucket i > 0 counts [2^(i-1), 2^i). Recording is one relaxed atomic increment.
+    {
+        static constexpr std::size_t bucket_count = std::numeric_limits<std::size_t>::digits + 1uz;
+        static constexpr std::size_t bucket_index(std::size_t value) noexcept { return std::bit_width(value); }
+        static constexpr std::size_t bucket_lower_bound(std::size_t index) noexcept { return index == 0uz ? 0uz : 1uz << (index - 1uz); }
+
+        std::atomic<std::uint64_t> buckets[bucket_count] = {};
+
+        void record(std::size_t value) noexcept { buckets[bucket_index(value)].fetch_add(1u, std::memory_order_relaxed); }
+        std::uint64_t count(std::size_t index) const noexcept { return buckets[index].load(std::memory_order_relaxed); }
+        void reset() noexcept
+        {
+            for (std::atomic<std::uint64_t> &bucket : buckets)
+                bucket.store(0u, std::memory_order_relaxed);
+        }
+    };
+
+    struct generator_counters_t // What generator_counting_hooks_t records. Counters are updated with relaxed atomics, so they can be read (e.g. sampled periodically to get yields per second) from any thread while generators run.
+    {
+        std::atomic<std::uint64_t> frame_allocations = 0u, frame_deallocations = 0u;
+        std::atomic<std::uint64_t> frame_bytes_allocated = 0u, frame_bytes_deallocated = 0u; // Sums of frame_size, the allocator may round up.
+        std::atomic<std::uint64_t> grafts = 0u, resumes = 0u, advances = 0u, exceptions = 0u;
+        generator_log2_histogram_t frame_sizes, graft_depths, exception_depths;
+
+        std::uint64_t frames_live() const noexcept { return frame_allocations.load(std::memory_order_relaxed) - frame_deallocations.load(std::memory_order_relaxed); }
+        std::uint64_t frame_bytes_live() const noexcept { return frame_bytes_allocated.load(std::memory_order_relaxed) - frame_bytes_deallocated.load(std::memory_order_relaxed); }
+        void reset() noexcept
+        {
+            for (std::atomic<std::uint64_t> *p_counter : {&frame_allocations, &frame_deallocations, &frame_bytes_allocated, &frame_bytes_deallocated, &grafts, &resumes, &advances, &exceptions})
+                p_counter->store(0u, std::memory_order_relaxed);
+            frame_sizes.reset();
+            graft_depths.reset();
+            exception_depths.reset();
+        }
+    };
+
+    template<typename tag_t = void>
+    struct generator_counting_hooks_t : public generator_no_hooks_t // Records every hook into counters. Generators whose traits use different tag_t are counted separately.
+    {
+        inline static generator_counters_t counters;
+
+        static void on_frame_allocate(std::size_t frame_size) noexcept
+        {
+            counters.frame_allocations.fetch_add(1u, std::memory_order_relaxed);
+            counters.frame_bytes_allocated.fetch_add(frame_size, std::memory_order_relaxed);
+            counters.frame_sizes.record(frame_size);
+        }
+        static void on_frame_deallocate(std::size_t frame_size) noexcept
+        {
+            counters.frame_deallocations.fetch_add(1u, std::memory_order_relaxed);
+            counters.frame_bytes_deallocated.fetch_add(frame_size, std::memory_order_relaxed);
+        }
+        static void on_graft(std::size_t depth) noexcept
+        {
+            counters.grafts.fetch_add(1u, std::memory_order_relaxed);
+            counters.graft_depths.record(depth);
+        }
+        static void on_resume() noexcept { counters.resumes.fetch_add(1u, std::memory_order_relaxed); }
+        static void on_advance() noexcept { counters.advances.fetch_add(1u, std::memory_order_relaxed); }
+        static void on_exception(std::size_t depth) noexcept
+        {
+            counters.exceptions.fetch_add(1u, std::memory_order_relaxed);
+            counters.exception_depths.record(depth);
+        }
+    };
+} // namespace ext
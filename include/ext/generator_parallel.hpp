@@ -0,0 +1,206 @@
+#pragma once
+
+#include "generator.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ext
+{
+    template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_, typename sink_t>
+    struct parallel_for_each_t : public generator_promise_base_t<typename generator_t<reference_t_, value_t_, yielded_t_, traits_t_>::yielded_t>::parallel_spawner_t // A work-stealing pool which consumes a generator tree: every subtree grafted by co_yield std::ranges::elements_of(generator) becomes a task that any worker can run.
+    {
+        using generator_t = ext::generator_t<reference_t_, value_t_, yielded_t_, traits_t_>;
+        using promise_t = typename generator_t::promise_t;
+        using parallel_spawner_t = typename promise_t::parallel_spawner_t;
+
+        struct worker_t
+        {
+            std::mutex mutex;
+            std::deque<generator_t> tasks; // The owner pushes and pops at the back (depth-first, cache-warm), thieves take from the front (the oldest, usually largest, subtrees).
+        };
+
+        sink_t &sink;
+        std::size_t worker_count;
+        std::unique_ptr<worker_t[]> p_workers;
+        std::atomic<std::size_t> task_count; // Tasks spawned and not finished (run or discarded). The pool is done when it drops to 0.
+        std::atomic<std::size_t> idle_count; // Workers which found no task and are about to wait on epoch.
+        std::atomic<std::size_t> epoch; // Changed when a task is spawned while a worker is idle, or when the pool is done.
+        std::atomic<bool> cancelled; // Set on the first exception: workers stop consuming and discard the remaining tasks.
+        std::mutex exception_mutex;
+        std::exception_ptr p_exception;
+        inline static thread_local parallel_for_each_t *p_pool_current = nullptr; // The pool whose worker the calling thread is running, if any.
+        inline static thread_local worker_t *p_worker_current = nullptr; // The calling thread's worker, which spawn() pushes to.
+
+        parallel_for_each_t(sink_t &sink, std::size_t worker_count) : parallel_spawner_t{.spawn = &parallel_for_each_t::spawn}, sink(sink), worker_count(worker_count == 0uz ? 1uz : worker_count), p_workers(std::make_unique<worker_t[]>(this->worker_count)), task_count(0uz), idle_count(0uz), epoch(0uz), cancelled(false) {}
+        parallel_for_each_t(parallel_for_each_t const &) = delete;
+        parallel_for_each_t &operator=(parallel_for_each_t const &) = delete;
+
+        void push(worker_t &worker, generator_t &&task)
+        {
+            task_count.fetch_add(1uz, std::memory_order_relaxed);
+            try
+            {
+                std::lock_guard lock(worker.mutex);
+                worker.tasks.push_back(std::move(task));
+            }
+            catch (...)
+            {
+                task_count.fetch_sub(1uz, std::memory_order_relaxed);
+                throw;
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in run_worker(): either the idle worker finds the task or this sees it idle
+            if (idle_count.load(std::memory_order_relaxed) != 0uz)
+            {
+                epoch.fetch_add(1uz, std::memory_order_relaxed);
+                epoch.notify_all();
+            }
+        }
+        static bool spawn(parallel_spawner_t &parallel_spawner, std::coroutine_handle<promise_t> handle) noexcept
+        {
+            parallel_for_each_t &self = static_cast<parallel_for_each_t &>(parallel_spawner);
+            if (p_pool_current != std::addressof(self)) // not resumed by one of this pool's workers
+                return false;
+            generator_t task(handle);
+            try
+            {
+                self.push(*p_worker_current, std::move(task));
+                return true;
+            }
+            catch (...)
+            {
+                task.handle = nullptr; // still owned by the caller, which grafts it
+                return false;
+            }
+        }
+        std::optional<generator_t> pop(std::size_t worker_index)
+        {
+            {
+                worker_t &worker = p_workers[worker_index];
+                std::lock_guard lock(worker.mutex);
+                if (!worker.tasks.empty())
+                {
+                    std::optional<generator_t> task(std::move(worker.tasks.back()));
+                    worker.tasks.pop_back();
+                    return task;
+                }
+            }
+            for (std::size_t i = 1uz; i != worker_count; ++i)
+            {
+                worker_t &victim = p_workers[(worker_index + i) % worker_count];
+                std::lock_guard lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    std::optional<generator_t> task(std::move(victim.tasks.front()));
+                    victim.tasks.pop_front();
+                    return task;
+                }
+            }
+            return std::nullopt;
+        }
+        void fail(std::exception_ptr p_exception_) noexcept
+        {
+            {
+                std::lock_guard lock(exception_mutex);
+                if (!p_exception)
+                    p_exception = std::move(p_exception_);
+            }
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+        void run(generator_t &task, std::size_t worker_index) noexcept
+        {
+            if (cancelled.load(std::memory_order_relaxed))
+                return;
+            try
+            {
+                if (!task.handle.done() && task.handle.promise().p_promise_root_or_current->p_yielded == nullptr) // a lazy subtree which has not started
+                {
+                    traits_t_::hooks_t::on_resume();
+                    task.handle.resume();
+                }
+                for (typename generator_t::iterator_t iterator{.handle = task.handle}; iterator != std::default_sentinel && !cancelled.load(std::memory_order_relaxed); ++iterator)
+                    std::invoke(sink, worker_index, *iterator);
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+            }
+        }
+        void run_worker(std::size_t worker_index) noexcept
+        {
+            parallel_for_each_t *p_pool_previous = std::exchange(p_pool_current, this);
+            worker_t *p_worker_previous = std::exchange(p_worker_current, std::addressof(p_workers[worker_index]));
+            for (;;)
+            {
+                std::optional<generator_t> task = pop(worker_index);
+                if (!task.has_value())
+                {
+                    std::size_t epoch_observed = epoch.load(std::memory_order_acquire);
+                    idle_count.fetch_add(1uz, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in push()
+                    if (task_count.load(std::memory_order_acquire) == 0uz)
+                    {
+                        idle_count.fetch_sub(1uz, std::memory_order_relaxed);
+                        break;
+                    }
+                    task = pop(worker_index);
+                    if (!task.has_value())
+                        epoch.wait(epoch_observed, std::memory_order_acquire);
+                    idle_count.fetch_sub(1uz, std::memory_order_relaxed);
+                    if (!task.has_value())
+                        continue;
+                }
+                run(*task, worker_index);
+                task.reset(); // destroys the coroutine states on this thread
+                if (task_count.fetch_sub(1uz, std::memory_order_acq_rel) == 1uz)
+                {
+                    epoch.fetch_add(1uz, std::memory_order_release);
+                    epoch.notify_all();
+                }
+            }
+            p_worker_current = p_worker_previous;
+            p_pool_current = p_pool_previous;
+        }
+    };
+
+    // Consumes generator on worker_count threads (the calling thread and worker_count - 1 new ones), in no particular order: every co_yield std::ranges::elements_of(generator) in a coroutine whose traits_t::spawns_in_parallel is true hands the subtree to the pool instead of grafting it, so sibling subtrees run concurrently; elements of a single coroutine keep their order.
+    // A spawned subtree may outlive the locals and parameters of the coroutine which spawned it, and its exception is not rethrown by that coroutine's co_yield. Coroutines whose traits_t::spawns_in_parallel is false graft their subtrees as in sequential iteration, on the worker which runs them.
+    // sink is invoked concurrently as std::invoke(sink, worker_index, reference) with worker_index < worker_count, so per-worker sinks (e.g. sinks[worker_index]) need no synchronization.
+    // The first exception thrown by a coroutine or by sink stops the pool and is rethrown once all workers have joined.
+    template<typename reference_t_, typename value_t_, typename yielded_t_, typename traits_t_, typename sink_t> requires std::invocable<sink_t &, std::size_t, typename generator_t<reference_t_, value_t_, yielded_t_, traits_t_>::reference_t>
+    void parallel_for_each(generator_t<reference_t_, value_t_, yielded_t_, traits_t_> &&generator, sink_t &&sink, std::size_t worker_count = std::thread::hardware_concurrency())
+    {
+        assert(generator.joinable());
+        assert(generator.handle.promise().p_promise_continuation == nullptr); // assert(subtree.p_root->p_parent == nullptr)
+        using pool_t = parallel_for_each_t<reference_t_, value_t_, yielded_t_, traits_t_, std::remove_reference_t<sink_t>>;
+        pool_t pool(sink, worker_count);
+        generator.handle.promise().p_parallel_spawner = &pool;
+        pool.push(pool.p_workers[0], std::move(generator));
+        std::vector<std::thread> threads;
+        try
+        {
+            threads.reserve(pool.worker_count - 1uz);
+            for (std::size_t worker_index = 1uz; worker_index != pool.worker_count; ++worker_index)
+                threads.emplace_back(&pool_t::run_worker, &pool, worker_index);
+        }
+        catch (...)
+        {
+            // fewer workers, the ones which exist (at least the calling thread) steal all the tasks
+        }
+        pool.run_worker(0uz);
+        for (std::thread &thread : threads)
+            thread.join();
+        if (pool.p_exception)
+            std::rethrow_exception(pool.p_exception);
+    }
+} // namespace ext
@@ -0,0 +1,116 @@
+#include <ext/generator_async_prefetch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    std::vector<int> iota(int n)
+    {
+        std::vector<int> elements(static_cast<std::size_t>(n));
+        std::iota(elements.begin(), elements.end(), 0);
+        return elements;
+    }
+
+    ext::generator_t<int const &> count(int first, int last)
+    {
+        for (int i = first; i != last; ++i)
+            co_yield i;
+    }
+    ext::generator_t<int const &> count_nested(int n)
+    {
+        co_yield std::ranges::elements_of(count(0, n / 2));
+        co_yield std::ranges::elements_of(count(n / 2, n));
+    }
+    ext::lazy_generator_t<int const &> count_then_throw(int n)
+    {
+        for (int i = 0; i != n; ++i)
+            co_yield i;
+        throw std::runtime_error("count_then_throw");
+    }
+
+    struct destroyed_guard_t
+    {
+        std::atomic<bool> &destroyed;
+        ~destroyed_guard_t() { destroyed.store(true); }
+    };
+    ext::generator_t<int const &> count_forever(std::atomic<int> &produced, std::atomic<bool> &destroyed)
+    {
+        destroyed_guard_t guard{.destroyed = destroyed};
+        for (int i = 0;; ++i)
+        {
+            produced.store(i + 1);
+            co_yield i;
+        }
+    }
+} // namespace
+
+TEST(generator_async_prefetch, order_and_count)
+{
+    for (std::size_t capacity : {1uz, 3uz, 64uz, 4096uz})
+    {
+        std::vector<int> elements;
+        for (int &e : ext::async_prefetch(count(0, 10000), capacity))
+            elements.push_back(e);
+        EXPECT_EQ(elements, iota(10000)) << "capacity = " << capacity;
+    }
+    std::vector<int> elements;
+    for (int &e : ext::async_prefetch(count_nested(1000), 16uz))
+        elements.push_back(e);
+    EXPECT_EQ(elements, iota(1000));
+}
+
+TEST(generator_async_prefetch, empty)
+{
+    auto view = ext::async_prefetch(count(0, 0), 16uz);
+    EXPECT_TRUE(view.begin() == view.end());
+}
+
+TEST(generator_async_prefetch, exception_after_elements)
+{
+    for (int n : {0, 1, 5, 100})
+    {
+        std::vector<int> elements;
+        auto view = ext::async_prefetch(count_then_throw(n), 8uz);
+        EXPECT_THROW(
+            {
+                for (int &e : view)
+                    elements.push_back(e);
+            },
+            std::runtime_error
+        );
+        EXPECT_EQ(elements, iota(n)) << "n = " << n;
+    }
+}
+
+TEST(generator_async_prefetch, destruction_stops_and_joins_worker)
+{
+    constexpr std::size_t capacity = 8uz;
+    std::atomic<int> produced = 0;
+    std::atomic<bool> destroyed = false;
+    {
+        auto view = ext::async_prefetch(count_forever(produced, destroyed), capacity);
+        int consumed = 0;
+        for (int &e : view)
+        {
+            EXPECT_EQ(e, consumed);
+            if (++consumed == 5)
+                break;
+        }
+    }
+    EXPECT_TRUE(destroyed.load()); // the worker destroyed the generator before it was joined
+    EXPECT_LE(produced.load(), 5 + static_cast<int>(capacity) + 1); // at most a ring's worth of elements (and the one which found it stopped) is produced in vain
+
+    produced = 0;
+    destroyed = false;
+    {
+        auto view = ext::async_prefetch(count_forever(produced, destroyed), capacity);
+    }
+    EXPECT_TRUE(destroyed.load());
+    EXPECT_LE(produced.load(), static_cast<int>(capacity) + 1);
+}
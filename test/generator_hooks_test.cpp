@@ -0,0 +1,188 @@
+#include <ext/generator_hooks.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    template<typename tag_t>
+    struct counting_traits_t : public ext::generator_traits_t
+    {
+        using hooks_t = ext::generator_counting_hooks_t<tag_t>;
+    };
+    template<typename tag_t>
+    using counted_generator_t = ext::generator_t<int, void, void, counting_traits_t<tag_t>>;
+
+    template<typename value_t>
+    struct stateless_throwing_allocator_t // Always throws. Stateless, so it is not stored in the coroutine state.
+    {
+        using value_type = value_t;
+        stateless_throwing_allocator_t() noexcept = default;
+        template<typename value_other_t>
+        stateless_throwing_allocator_t(stateless_throwing_allocator_t<value_other_t> const &) noexcept {}
+        value_t *allocate(std::size_t) { throw std::bad_alloc(); }
+        void deallocate(value_t *, std::size_t) noexcept {}
+        template<typename value_other_t>
+        friend bool operator==(stateless_throwing_allocator_t const &, stateless_throwing_allocator_t<value_other_t> const &) noexcept { return true; }
+    };
+    template<typename value_t>
+    struct stateful_throwing_allocator_t // Throws if fails, otherwise allocates from ::operator new. Stored in the coroutine state.
+    {
+        using value_type = value_t;
+        bool fails;
+        stateful_throwing_allocator_t(bool fails) noexcept : fails(fails) {}
+        template<typename value_other_t>
+        stateful_throwing_allocator_t(stateful_throwing_allocator_t<value_other_t> const &other) noexcept : fails(other.fails) {}
+        value_t *allocate(std::size_t n)
+        {
+            if (fails)
+                throw std::bad_alloc();
+            return static_cast<value_t *>(::operator new(n * sizeof(value_t)));
+        }
+        void deallocate(value_t *p, std::size_t n) noexcept { ::operator delete(p, n * sizeof(value_t)); }
+        template<typename value_other_t>
+        friend bool operator==(stateful_throwing_allocator_t const &lhs, stateful_throwing_allocator_t<value_other_t> const &rhs) noexcept { return lhs.fails == rhs.fails; }
+    };
+
+    struct allocation_failure_tag_t;
+    counted_generator_t<allocation_failure_tag_t> stateless_throwing(std::allocator_arg_t, stateless_throwing_allocator_t<void>)
+    {
+        co_yield 1;
+    }
+    counted_generator_t<allocation_failure_tag_t> stateful_throwing(std::allocator_arg_t, stateful_throwing_allocator_t<void>)
+    {
+        co_yield 1;
+    }
+
+    std::vector<std::uint64_t> low_buckets(ext::generator_log2_histogram_t const &histogram) // Buckets 0 to 4, i.e. values 0, 1, [2, 4), [4, 8), [8, 16).
+    {
+        std::vector<std::uint64_t> counts;
+        for (std::size_t index = 0uz; index != 5uz; ++index)
+            counts.push_back(histogram.count(index));
+        return counts;
+    }
+    template<typename generator_t>
+    std::vector<int> collect(generator_t &&generator)
+    {
+        std::vector<int> elements;
+        for (int e : generator)
+            elements.push_back(e);
+        return elements;
+    }
+
+    struct tree_tag_t;
+    counted_generator_t<tree_tag_t> leaf()
+    {
+        co_yield 3;
+    }
+    counted_generator_t<tree_tag_t> middle()
+    {
+        co_yield 2;
+        co_yield std::ranges::elements_of(leaf());
+    }
+    counted_generator_t<tree_tag_t> root()
+    {
+        co_yield 1;
+        co_yield std::ranges::elements_of(middle());
+        co_yield std::ranges::elements_of(std::views::iota(4, 6)); // advanced in place, without resuming
+        co_yield 6;
+    }
+
+    struct exception_tag_t;
+    counted_generator_t<exception_tag_t> throwing_at(int depth) // Grafts throwing_at(depth + 1) up to depth 4, which yields 1 and throws.
+    {
+        if (depth == 4)
+        {
+            co_yield 1;
+            throw std::runtime_error("throwing_at");
+        }
+        co_yield std::ranges::elements_of(throwing_at(depth + 1));
+    }
+    counted_generator_t<exception_tag_t> catching_root(bool &caught)
+    {
+        try
+        {
+            co_yield std::ranges::elements_of(throwing_at(1));
+        }
+        catch (std::runtime_error const &)
+        {
+            caught = true;
+        }
+        co_yield 2;
+    }
+} // namespace
+
+TEST(generator_hooks, failed_allocation_is_not_counted)
+{
+    ext::generator_counters_t &counters = ext::generator_counting_hooks_t<allocation_failure_tag_t>::counters;
+    counters.reset();
+    EXPECT_THROW(stateless_throwing(std::allocator_arg, {}), std::bad_alloc);
+    EXPECT_THROW(stateful_throwing(std::allocator_arg, true), std::bad_alloc);
+    EXPECT_EQ(counters.frame_allocations.load(), 0u);
+    EXPECT_EQ(counters.frames_live(), 0u);
+    EXPECT_EQ(counters.frame_bytes_live(), 0u);
+
+    {
+        counted_generator_t<allocation_failure_tag_t> generator = stateful_throwing(std::allocator_arg, false);
+        EXPECT_EQ(counters.frame_allocations.load(), 1u);
+        EXPECT_EQ(counters.frames_live(), 1u);
+    }
+    EXPECT_EQ(counters.frames_live(), 0u);
+    EXPECT_EQ(counters.frame_bytes_live(), 0u);
+}
+
+TEST(generator_hooks, counts_a_known_tree)
+{
+    ext::generator_counters_t &counters = ext::generator_counting_hooks_t<tree_tag_t>::counters;
+    counters.reset();
+    EXPECT_EQ(collect(root()), (std::vector<int>{1, 2, 3, 4, 5, 6}));
+    EXPECT_EQ(counters.frame_allocations.load(), 3u);
+    EXPECT_EQ(counters.frame_deallocations.load(), 3u);
+    EXPECT_EQ(counters.frames_live(), 0u);
+    EXPECT_EQ(counters.frame_bytes_live(), 0u);
+    EXPECT_NE(counters.frame_bytes_allocated.load(), 0u);
+    std::uint64_t frame_sizes = 0u;
+    for (std::size_t index = 0uz; index != ext::generator_log2_histogram_t::bucket_count; ++index)
+        frame_sizes += counters.frame_sizes.count(index);
+    EXPECT_EQ(frame_sizes, 3u);
+    EXPECT_EQ(counters.grafts.load(), 2u);
+    EXPECT_EQ(low_buckets(counters.graft_depths), (std::vector<std::uint64_t>{0u, 1u, 1u, 0u, 0u})); // middle at depth 1, leaf at depth 2
+    EXPECT_EQ(counters.advances.load(), 6u); // one per element, the last one reaching the end
+    EXPECT_EQ(counters.resumes.load(), 5u); // every advance but the one from 4 to 5, which steps through the range in place
+    EXPECT_EQ(counters.exceptions.load(), 0u);
+}
+
+TEST(generator_hooks, records_each_depth_an_exception_crosses)
+{
+    ext::generator_counters_t &counters = ext::generator_counting_hooks_t<exception_tag_t>::counters;
+    counters.reset();
+    bool caught = false;
+    EXPECT_EQ(collect(catching_root(caught)), (std::vector<int>{1, 2}));
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(counters.grafts.load(), 4u);
+    EXPECT_EQ(low_buckets(counters.graft_depths), (std::vector<std::uint64_t>{0u, 1u, 2u, 1u, 0u})); // each eager throwing_at grafts the started rest of the chain below it: depths 1, 2, 3, 4
+    EXPECT_EQ(counters.exceptions.load(), 4u);
+    EXPECT_EQ(low_buckets(counters.exception_depths), (std::vector<std::uint64_t>{0u, 1u, 2u, 1u, 0u})); // thrown at depth 4, crosses 3, 2 and 1, caught by the root
+    EXPECT_EQ(counters.frames_live(), 0u);
+
+    counters.reset();
+    std::vector<int> elements;
+    EXPECT_THROW(
+        {
+            for (int e : throwing_at(1))
+                elements.push_back(e);
+        },
+        std::runtime_error
+    );
+    EXPECT_EQ(elements, (std::vector<int>{1}));
+    EXPECT_EQ(counters.exceptions.load(), 4u);
+    EXPECT_EQ(low_buckets(counters.exception_depths), (std::vector<std::uint64_t>{1u, 1u, 2u, 0u, 0u})); // thrown at depth 3, crosses 2 and 1, then 0: rethrown to the consumer
+    EXPECT_EQ(counters.frames_live(), 0u);
+}
@@ -0,0 +1,126 @@
+#include <ext/generator_parallel.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    template<typename generator_t>
+    std::vector<std::vector<int>> parallel_collect(generator_t &&generator, std::size_t worker_count)
+    {
+        std::vector<std::vector<int>> elements(worker_count);
+        ext::parallel_for_each(std::move(generator), [&elements](std::size_t worker_index, int const &e) { elements[worker_index].push_back(e); }, worker_count);
+        return elements;
+    }
+    std::vector<int> sorted(std::vector<std::vector<int>> const &elements)
+    {
+        std::vector<int> all;
+        for (std::vector<int> const &worker_elements : elements)
+            all.insert(all.end(), worker_elements.begin(), worker_elements.end());
+        std::ranges::sort(all);
+        return all;
+    }
+    std::vector<int> iota(int first, int last)
+    {
+        std::vector<int> elements(static_cast<std::size_t>(last - first));
+        std::iota(elements.begin(), elements.end(), first);
+        return elements;
+    }
+
+    // Producers written for sequential iteration: subtrees refer to the caller's locals, exceptions are caught around co_yield.
+    ext::generator_t<int const &> borrow(std::vector<int> const &v)
+    {
+        for (int const &e : v)
+            co_yield e;
+    }
+    ext::generator_t<int const &> owner()
+    {
+        co_yield -1;
+        std::vector<int> local(50);
+        std::iota(local.begin(), local.end(), 0);
+        co_yield std::ranges::elements_of(borrow(local));
+        for (int i = 0; i != 2; ++i)
+        {
+            std::vector<int> local_per_iteration(1, 50 + i);
+            co_yield std::ranges::elements_of(borrow(local_per_iteration));
+        }
+    }
+
+    template<typename traits_t>
+    ext::generator_t<int const &, void, void, traits_t> throw_after_one()
+    {
+        co_yield 1;
+        throw std::runtime_error("throw_after_one");
+    }
+    template<typename traits_t>
+    ext::generator_t<int const &, void, void, traits_t> catching(bool &caught)
+    {
+        co_yield 0;
+        try
+        {
+            co_yield std::ranges::elements_of(throw_after_one<traits_t>());
+        }
+        catch (std::runtime_error const &)
+        {
+            caught = true;
+        }
+        co_yield 2;
+    }
+
+    // Opted in: subtrees take their arguments by value. Yields [first, first + size).
+    ext::generator_t<int const &, void, void, ext::parallel_generator_traits_t> spawning_tree(int first, int size)
+    {
+        if (size == 1)
+            co_yield first;
+        else if (size != 0)
+        {
+            co_yield std::ranges::elements_of(spawning_tree(first, size / 2));
+            co_yield std::ranges::elements_of(spawning_tree(first + size / 2, size - size / 2));
+        }
+    }
+} // namespace
+
+TEST(generator_parallel, default_traits_graft_and_keep_borrowed_locals)
+{
+    for (std::size_t worker_count : {1uz, 4uz})
+    {
+        std::vector<std::vector<int>> elements = parallel_collect(owner(), worker_count);
+        std::size_t non_empty = 0;
+        for (std::vector<int> const &worker_elements : elements)
+            if (!worker_elements.empty())
+            {
+                ++non_empty;
+                EXPECT_EQ(worker_elements, iota(-1, 52)); // one worker, in order
+            }
+        EXPECT_EQ(non_empty, 1uz) << "worker_count = " << worker_count;
+    }
+}
+
+TEST(generator_parallel, default_traits_rethrow_at_co_yield)
+{
+    bool caught = false;
+    std::vector<std::vector<int>> elements;
+    EXPECT_NO_THROW(elements = parallel_collect(catching<ext::generator_traits_t>(caught), 2uz));
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(sorted(elements), (std::vector<int>{0, 1, 2}));
+}
+
+TEST(generator_parallel, spawning_traits_consume_every_element)
+{
+    for (std::size_t worker_count : {1uz, 2uz, 4uz})
+        EXPECT_EQ(sorted(parallel_collect(spawning_tree(0, 1000), worker_count)), iota(0, 1000)) << "worker_count = " << worker_count;
+}
+
+TEST(generator_parallel, spawning_traits_rethrow_from_parallel_for_each)
+{
+    bool caught = false;
+    EXPECT_THROW(parallel_collect(catching<ext::parallel_generator_traits_t>(caught), 1uz), std::runtime_error);
+    EXPECT_FALSE(caught); // the spawned subtree's exception does not reach the co_yield which spawned it
+}
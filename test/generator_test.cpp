@@ -0,0 +1,946 @@
+#include <ext/generator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <list>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    template<typename generator_t>
+    std::vector<typename std::remove_cvref_t<generator_t>::value_t> collect(generator_t &&generator)
+    {
+        std::vector<typename std::remove_cvref_t<generator_t>::value_t> elements;
+        for (auto &&e : generator)
+            elements.push_back(e);
+        return elements;
+    }
+
+    // Each counts how many times its body started in runs.
+    ext::generator_t<int> eager_two(int &runs)
+    {
+        ++runs;
+        co_yield 1;
+        co_yield 2;
+    }
+    ext::lazy_generator_t<int> lazy_two(int &runs)
+    {
+        ++runs;
+        co_yield 1;
+        co_yield 2;
+    }
+    ext::lazy_generator_t<int> lazy_none(int &runs)
+    {
+        ++runs;
+        co_return;
+    }
+    ext::lazy_generator_t<int> lazy_throw_after_one(int &runs)
+    {
+        ++runs;
+        co_yield 1;
+        throw std::runtime_error("lazy_throw_after_one");
+    }
+    ext::lazy_generator_t<int> lazy_throw_before_first(int &runs)
+    {
+        ++runs;
+        throw std::runtime_error("lazy_throw_before_first");
+        co_return;
+    }
+
+    template<typename child_t>
+    ext::generator_t<int> eager_catching(child_t child)
+    {
+        co_yield 0;
+        bool caught = false;
+        try
+        {
+            co_yield std::ranges::elements_of(std::move(child));
+        }
+        catch (std::runtime_error const &)
+        {
+            caught = true;
+        }
+        if (caught)
+            co_yield -1;
+        co_yield 3;
+    }
+
+    ext::generator_t<int> eager_throw_after_one()
+    {
+        co_yield 1;
+        throw std::runtime_error("eager_throw_after_one");
+    }
+    ext::generator_t<int> eager_forwarding(int levels)
+    {
+        if (levels == 0)
+            co_yield std::ranges::elements_of(eager_throw_after_one());
+        else
+            co_yield std::ranges::elements_of(eager_forwarding(levels - 1));
+    }
+
+    ext::generator_t<int> nest(int level) // level * 10, the elements of nest(level - 1), level * 10 + 1
+    {
+        co_yield level * 10;
+        if (level != 1)
+            co_yield std::ranges::elements_of(nest(level - 1));
+        co_yield level * 10 + 1;
+    }
+    ext::generator_t<int> nest_throwing(int level, int catch_at) // level * 10, the elements of nest_throwing(level - 1, catch_at), level * 10 + 1, where level 1 throws after 10 and the level catch_at catches it and yields -catch_at
+    {
+        co_yield level * 10;
+        if (level == 1)
+            throw std::runtime_error("nest_throwing");
+        bool caught = false;
+        try
+        {
+            co_yield std::ranges::elements_of(nest_throwing(level - 1, catch_at));
+        }
+        catch (std::runtime_error const &)
+        {
+            if (level != catch_at)
+                throw;
+            caught = true;
+        }
+        if (caught)
+            co_yield -level;
+        co_yield level * 10 + 1;
+    }
+    ext::generator_t<int> graft_after(ext::generator_t<int> child, int consumed, int after, bool &caught) // Consumes the first consumed elements of child, grafts the started rest, then yields after.
+    {
+        auto iterator = child.begin();
+        for (int i = 0; i != consumed; ++i)
+            ++iterator;
+        try
+        {
+            co_yield std::ranges::elements_of(std::move(child));
+        }
+        catch (std::runtime_error const &)
+        {
+            caught = true;
+        }
+        co_yield int(after);
+    }
+
+    template<typename generator_t>
+    std::vector<std::vector<int>> collect_chunks(generator_t &&generator)
+    {
+        std::vector<std::vector<int>> chunks;
+        for (auto chunk : generator.chunks())
+            chunks.emplace_back(chunk.begin(), chunk.end());
+        return chunks;
+    }
+    ext::generator_t<int const &> mixed(std::vector<int> const &v, std::list<int> const &l) // 1, v, l, 7, then a nested generator's 8 9
+    {
+        co_yield 1;
+        co_yield std::ranges::elements_of(v);
+        co_yield std::ranges::elements_of(l);
+        co_yield std::ranges::elements_of(std::vector<int>());
+        co_yield 7;
+        co_yield std::ranges::elements_of([]() -> ext::generator_t<int const &> {
+            std::vector<int> local(2, 8);
+            local[1] = 9;
+            co_yield std::ranges::elements_of(local);
+        }());
+    }
+
+    std::size_t cached_blocks(ext::generator_frame_pool_t const &pool)
+    {
+        std::size_t count = 0uz;
+        for (ext::generator_frame_pool_t::free_block_t const *p_free_block : pool.p_free_blocks)
+            for (; p_free_block != nullptr; p_free_block = p_free_block->p_next)
+                ++count;
+        return count;
+    }
+    ext::generator_t<int> small_frame()
+    {
+        co_yield 1;
+    }
+    ext::generator_t<int> large_frame()
+    {
+        std::array<char, ext::generator_frame_pool_t::size_class_count * ext::generator_frame_pool_t::size_class_granularity> large{};
+        co_yield 1;
+        co_yield int(large[0]);
+    }
+    ext::generator_t<int> explicit_pool_frame(std::allocator_arg_t, ext::generator_frame_pool_allocator_t<void>)
+    {
+        co_yield 1;
+    }
+
+    struct caching_traits_t : public ext::generator_traits_t
+    {
+        static constexpr bool caches_value = true;
+    };
+    struct counts_t
+    {
+        int constructions = 0, copies = 0, moves = 0, copy_assignments = 0, move_assignments = 0, destructions = 0;
+        bool operator==(counts_t const &) const = default;
+        friend std::ostream &operator<<(std::ostream &os, counts_t const &counts) { return os << "{constructions = " << counts.constructions << ", copies = " << counts.copies << ", moves = " << counts.moves << ", copy_assignments = " << counts.copy_assignments << ", move_assignments = " << counts.move_assignments << ", destructions = " << counts.destructions << "}"; }
+    };
+    counts_t counts;
+    struct counted_t // Counts its special member functions into counts. A moved-from counted_t has value -1.
+    {
+        int value;
+        counted_t(int value) : value(value) { ++counts.constructions; }
+        counted_t(counted_t const &other) : value(other.value) { ++counts.copies; }
+        counted_t(counted_t &&other) noexcept : value(std::exchange(other.value, -1)) { ++counts.moves; }
+        counted_t &operator=(counted_t const &other)
+        {
+            value = other.value;
+            ++counts.copy_assignments;
+            return *this;
+        }
+        counted_t &operator=(counted_t &&other) noexcept
+        {
+            value = std::exchange(other.value, -1);
+            ++counts.move_assignments;
+            return *this;
+        }
+        ~counted_t() { ++counts.destructions; }
+    };
+
+    template<typename range_t>
+    ext::generator_t<int const &> catching_range(range_t range)
+    {
+        co_yield -2;
+        bool caught = false;
+        try
+        {
+            co_yield std::ranges::elements_of(range);
+        }
+        catch (std::runtime_error const &)
+        {
+            caught = true;
+        }
+        if (caught)
+            co_yield -1;
+        co_yield 100;
+    }
+    struct throwing_increment_range_t // [0, size), incrementing to throw_at throws. Its reference binds directly but it is not contiguous.
+    {
+        int size, throw_at;
+        struct iterator_t
+        {
+            int i, throw_at;
+            using difference_type = std::ptrdiff_t;
+            using value_type = int;
+            int const &operator*() const { return i; }
+            iterator_t &operator++()
+            {
+                if (i + 1 == throw_at)
+                    throw std::runtime_error("throwing_increment_range_t");
+                ++i;
+                return *this;
+            }
+            void operator++(int) { ++*this; }
+        };
+        struct sentinel_t
+        {
+            int size;
+            friend bool operator==(iterator_t const &iterator, sentinel_t const &sentinel) { return iterator.i == sentinel.size; }
+        };
+        iterator_t begin() const { return {.i = 0, .throw_at = throw_at}; }
+        sentinel_t end() const { return {.size = size}; }
+    };
+    auto throwing_dereference_range(int size, int throw_at) // [0, size), dereferencing throw_at throws. Its reference is a prvalue.
+    {
+        return std::views::iota(0, size) | std::views::transform([throw_at](int i) {
+                   if (i == throw_at)
+                       throw std::runtime_error("throwing_dereference_range");
+                   return i;
+               });
+    }
+
+    struct teardown_t
+    {
+        int destroyed = 0; // Frames destroyed so far.
+        bool leaf_first = true; // Whether each frame was destroyed after all the frames below it.
+    };
+    struct teardown_guard_t
+    {
+        teardown_t &teardown;
+        int depth;
+        ~teardown_guard_t()
+        {
+            teardown.leaf_first = teardown.leaf_first && teardown.destroyed == depth - 1;
+            ++teardown.destroyed;
+        }
+    };
+    ext::lazy_generator_t<int> lazy_chain(int depth, teardown_t &teardown)
+    {
+        teardown_guard_t guard{.teardown = teardown, .depth = depth};
+        co_yield int(depth);
+        if (depth != 1)
+            co_yield std::ranges::elements_of(lazy_chain(depth - 1, teardown));
+    }
+
+    ext::generator_t<int const &> ranges_of(std::vector<std::vector<int>> const &vs)
+    {
+        for (std::vector<int> const &v : vs)
+            co_yield std::ranges::elements_of(v);
+        co_yield -1;
+    }
+    ext::generator_t<int const &> iota_then_nested(int n)
+    {
+        co_yield std::ranges::elements_of(std::views::iota(0, n)); // sized, not contiguous
+        co_yield std::ranges::elements_of([]() -> ext::generator_t<int const &> { co_yield std::ranges::elements_of(std::vector<int>(5, 7)); }());
+        co_yield -1;
+    }
+    ext::generator_t<int const &> declared(int n)
+    {
+        co_yield ext::generator_size_hint_t{.size = static_cast<std::size_t>(n)};
+        co_yield std::ranges::elements_of(std::views::iota(0, n));
+    }
+} // namespace
+
+TEST(generator_lazy, discarded_runs_no_body)
+{
+    int runs = 0;
+    {
+        ext::lazy_generator_t<int> generator = lazy_two(runs);
+        EXPECT_EQ(runs, 0);
+    }
+    EXPECT_EQ(runs, 0);
+
+    ext::generator_t<int> generator = eager_two(runs);
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(generator_lazy, empty_starts_once)
+{
+    int runs = 0;
+    ext::lazy_generator_t<int> generator = lazy_two(runs);
+    EXPECT_FALSE(generator.empty());
+    EXPECT_EQ(runs, 1);
+    EXPECT_FALSE(generator.empty());
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(collect(generator), (std::vector<int>{1, 2}));
+    EXPECT_EQ(runs, 1);
+    EXPECT_TRUE(generator.empty());
+
+    ext::lazy_generator_t<int> none = lazy_none(runs);
+    EXPECT_TRUE(none.empty());
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(generator_lazy, begin_starts_once)
+{
+    int runs = 0;
+    ext::lazy_generator_t<int> generator = lazy_two(runs);
+    EXPECT_EQ(*generator.begin(), 1);
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(*generator.begin(), 1);
+    EXPECT_EQ(collect(generator), (std::vector<int>{1, 2}));
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(generator_lazy, root_exception_is_rethrown_by_begin)
+{
+    int runs = 0;
+    ext::lazy_generator_t<int> generator = lazy_throw_before_first(runs);
+    EXPECT_EQ(runs, 0);
+    EXPECT_THROW(generator.begin(), std::runtime_error);
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(generator_lazy, grafted_child_starts)
+{
+    int runs = 0;
+    ext::generator_t<int> generator = eager_catching(lazy_two(runs));
+    EXPECT_EQ(runs, 0);
+    EXPECT_EQ(collect(generator), (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(generator_lazy, grafted_child_exception_reaches_parent)
+{
+    int runs = 0;
+    EXPECT_EQ(collect(eager_catching(lazy_throw_after_one(runs))), (std::vector<int>{0, 1, -1, 3}));
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(collect(eager_catching(lazy_throw_before_first(runs))), (std::vector<int>{0, -1, 3}));
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(generator_lazy, started_child_is_not_restarted_by_graft)
+{
+    int runs = 0;
+    ext::generator_t<int> generator = [](int &runs) -> ext::generator_t<int> {
+        ext::lazy_generator_t<int> child = lazy_two(runs);
+        co_yield *child.begin(); // 1
+        co_yield std::ranges::elements_of(std::move(child)); // 1 2
+    }(runs);
+    EXPECT_EQ(collect(generator), (std::vector<int>{1, 1, 2}));
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(generator_lazy, lazy_inside_eager)
+{
+    int runs = 0;
+    ext::generator_t<int> generator = [](int &runs) -> ext::generator_t<int> {
+        ext::lazy_generator_t<int> child = lazy_two(runs);
+        co_yield 0;
+        EXPECT_EQ(runs, 0);
+        co_yield std::ranges::elements_of(std::move(child));
+        co_yield 3;
+    }(runs);
+    EXPECT_EQ(collect(generator), (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(generator_lazy, eager_inside_lazy)
+{
+    int runs = 0, runs_parent = 0;
+    ext::lazy_generator_t<int> generator = [](int &runs, int &runs_parent) -> ext::lazy_generator_t<int> {
+        ++runs_parent;
+        ext::generator_t<int> child = eager_two(runs);
+        EXPECT_EQ(runs, 1);
+        co_yield 0;
+        co_yield std::ranges::elements_of(std::move(child));
+        co_yield std::ranges::elements_of(lazy_two(runs));
+        co_yield 3;
+    }(runs, runs_parent);
+    EXPECT_EQ(runs_parent, 0);
+    EXPECT_EQ(runs, 0);
+    EXPECT_EQ(collect(generator), (std::vector<int>{0, 1, 2, 1, 2, 3}));
+    EXPECT_EQ(runs_parent, 1);
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(generator_exception, nested_exception_reaches_co_yield)
+{
+    EXPECT_EQ(collect(eager_catching(eager_throw_after_one())), (std::vector<int>{0, 1, -1, 3}));
+    EXPECT_EQ(collect(eager_catching(eager_forwarding(3))), (std::vector<int>{0, 1, -1, 3})); // passes through the co_yield of each level in between
+}
+
+TEST(generator_exception, nested_exception_reaches_consumer)
+{
+    std::vector<int> elements;
+    EXPECT_THROW(
+        {
+            for (int e : eager_forwarding(2))
+                elements.push_back(e);
+        },
+        std::runtime_error
+    );
+    EXPECT_EQ(elements, (std::vector<int>{1}));
+}
+
+TEST(generator_elements_of_range, contiguous_steps_through_the_range)
+{
+    std::vector<std::vector<int>> vs{{}, {1, 2, 3}, {}, {4}};
+    ext::generator_t<int const &> generator = ranges_of(vs);
+    std::vector<int const *> addresses;
+    for (int const &e : generator)
+        addresses.push_back(std::addressof(e));
+    EXPECT_EQ(addresses, (std::vector<int const *>{&vs[1][0], &vs[1][1], &vs[1][2], &vs[3][0], addresses.back()})); // the elements themselves, then -1
+    EXPECT_EQ(*addresses.back(), -1);
+}
+
+TEST(generator_elements_of_range, binds_directly_without_being_contiguous)
+{
+    std::list<std::string> l{"a", "bc", "def"};
+    ext::generator_t<std::string const &> generator = [](std::list<std::string> const &l) -> ext::generator_t<std::string const &> {
+        co_yield std::ranges::elements_of(l);
+    }(l);
+    auto iterator = generator.begin();
+    for (std::string const &e : l)
+    {
+        EXPECT_EQ(std::addressof(*iterator), std::addressof(e));
+        ++iterator;
+    }
+    EXPECT_TRUE(iterator == std::default_sentinel);
+}
+
+TEST(generator_elements_of_range, materializes_what_does_not_bind)
+{
+    std::vector<char const *> cs{"a", "bc", "def"};
+    EXPECT_EQ(collect([](std::vector<char const *> const &cs) -> ext::generator_t<std::string const &> {
+                  co_yield std::ranges::elements_of(cs);
+                  co_yield "g";
+              }(cs)),
+              (std::vector<std::string>{"a", "bc", "def", "g"}));
+    EXPECT_EQ(collect([]() -> ext::generator_t<int const &> {
+                  co_yield std::ranges::elements_of(std::views::iota(0, 4) | std::views::transform([](int i) { return i * i; }));
+              }()),
+              (std::vector<int>{0, 1, 4, 9}));
+}
+
+TEST(generator_elements_of_range, owns_a_moved_range)
+{
+    std::vector<int> local(3, 7);
+    ext::generator_t<int const &> generator = [](std::vector<int> &local) -> ext::generator_t<int const &> {
+        co_yield std::ranges::elements_of<std::vector<int>>(std::move(local));
+        co_yield -1;
+    }(local);
+    EXPECT_TRUE(local.empty()); // moved into the co_yield expression, which keeps it while suspended
+    EXPECT_EQ(collect(generator), (std::vector<int>{7, 7, 7, -1}));
+}
+
+TEST(generator_elements_of_range, exception_from_increment_reaches_co_yield)
+{
+    EXPECT_EQ(collect(catching_range(throwing_increment_range_t{.size = 5, .throw_at = 3})), (std::vector<int>{-2, 0, 1, 2, -1, 100}));
+    EXPECT_EQ(collect(catching_range(throwing_increment_range_t{.size = 5, .throw_at = 1})), (std::vector<int>{-2, 0, -1, 100}));
+    EXPECT_EQ(collect(catching_range(throwing_increment_range_t{.size = 5, .throw_at = 6})), (std::vector<int>{-2, 0, 1, 2, 3, 4, 100}));
+}
+
+TEST(generator_elements_of_range, exception_from_dereference_reaches_co_yield)
+{
+    EXPECT_EQ(collect(catching_range(throwing_dereference_range(5, 2))), (std::vector<int>{-2, 0, 1, -1, 100}));
+    EXPECT_EQ(collect(catching_range(throwing_dereference_range(5, 0))), (std::vector<int>{-2, -1, 100})); // the first element is produced when the co_yield suspends
+    EXPECT_EQ(collect(catching_range(throwing_dereference_range(5, 5))), (std::vector<int>{-2, 0, 1, 2, 3, 4, 100}));
+}
+
+TEST(generator_elements_of_range, not_sized)
+{
+    auto even = std::views::iota(0, 10) | std::views::filter([](int i) { return i % 2 == 0; });
+    static_assert(!std::ranges::sized_range<decltype(even)>);
+    ext::generator_t<int const &> generator = [](auto even) -> ext::generator_t<int const &> {
+        co_yield std::ranges::elements_of(even);
+    }(even);
+    EXPECT_EQ(generator.size_hint(), 0uz);
+    EXPECT_EQ(collect(generator), (std::vector<int>{0, 2, 4, 6, 8}));
+}
+
+TEST(generator_elements_of_range, input_only)
+{
+    std::istringstream in("3 1 4 1 5");
+    ext::generator_t<int const &> generator = [](std::istringstream &in) -> ext::generator_t<int const &> {
+        auto ints = std::views::istream<int>(in);
+        static_assert(!std::ranges::forward_range<decltype(ints)>);
+        co_yield std::ranges::elements_of(ints);
+        co_yield -1;
+    }(in);
+    EXPECT_EQ(collect(generator), (std::vector<int>{3, 1, 4, 1, 5, -1}));
+}
+
+TEST(generator_chunks, boundaries)
+{
+    std::vector<int> v{2, 3, 4};
+    std::list<int> l{5, 6};
+    EXPECT_EQ(collect_chunks(mixed(v, l)), (std::vector<std::vector<int>>{{1}, {2, 3, 4}, {5}, {6}, {7}, {8, 9}})); // a contiguous range is one chunk, a non-contiguous one is a chunk per element
+    ext::generator_t<int const &> generator = mixed(v, l);
+    auto chunk_iterator = generator.chunks().begin();
+    ++chunk_iterator;
+    EXPECT_EQ((*chunk_iterator).data(), v.data()); // the range itself, not a copy
+    EXPECT_EQ(collect_chunks([]() -> ext::generator_t<int const &> { co_return; }()), (std::vector<std::vector<int>>{}));
+}
+
+TEST(generator_chunks, mixed_with_begin)
+{
+    std::vector<int> v{2, 3, 4};
+    std::list<int> l{5, 6};
+    ext::generator_t<int const &> generator = mixed(v, l);
+    auto iterator = generator.begin();
+    ++iterator;
+    ++iterator;
+    EXPECT_EQ(*iterator, 3);
+    auto chunk_iterator = generator.chunks().begin();
+    EXPECT_EQ(std::vector<int>((*chunk_iterator).begin(), (*chunk_iterator).end()), (std::vector<int>{3, 4})); // the rest of the range, from where iterator is
+    ++chunk_iterator;
+    EXPECT_EQ(*iterator, 5); // iterator sees what the chunk iterator advanced to
+    ++iterator;
+    EXPECT_EQ(collect_chunks(generator), (std::vector<std::vector<int>>{{6}, {7}, {8, 9}}));
+}
+
+TEST(generator_frame_pool, reuses_blocks_within_a_size_class)
+{
+    constexpr std::size_t granularity = ext::generator_frame_pool_t::size_class_granularity;
+    ext::generator_frame_pool_t pool;
+    void *p = pool.allocate(granularity + 1uz);
+    pool.deallocate(p, granularity + 1uz);
+    EXPECT_EQ(cached_blocks(pool), 1uz);
+    void *q = pool.allocate(granularity * 2uz); // the same size class
+    EXPECT_EQ(q, p);
+    EXPECT_EQ(cached_blocks(pool), 0uz);
+    void *r = pool.allocate(granularity); // another size class
+    EXPECT_NE(r, q);
+    pool.deallocate(q, granularity * 2uz);
+    pool.deallocate(r, granularity);
+    EXPECT_EQ(cached_blocks(pool), 2uz);
+    EXPECT_EQ(pool.allocate(granularity), r);
+    pool.deallocate(r, granularity);
+}
+
+TEST(generator_frame_pool, large_frames_bypass_the_pool)
+{
+    constexpr std::size_t largest = ext::generator_frame_pool_t::size_class_count * ext::generator_frame_pool_t::size_class_granularity;
+    ext::generator_frame_pool_t pool;
+    pool.deallocate(pool.allocate(largest + 1uz), largest + 1uz);
+    EXPECT_EQ(cached_blocks(pool), 0uz);
+    pool.deallocate(pool.allocate(largest), largest);
+    EXPECT_EQ(cached_blocks(pool), 1uz);
+
+    ext::generator_frame_pool_t::thread_local_scope_t scope(pool);
+    pool.release();
+    EXPECT_EQ(collect(large_frame()), (std::vector<int>{1, 0}));
+    EXPECT_EQ(cached_blocks(pool), 0uz);
+    EXPECT_EQ(collect(small_frame()), (std::vector<int>{1}));
+    EXPECT_EQ(cached_blocks(pool), 1uz);
+}
+
+TEST(generator_frame_pool, default_allocator_reuses_frames)
+{
+    ext::generator_frame_pool_t pool;
+    ext::generator_frame_pool_t::thread_local_scope_t scope(pool);
+    void *p_frame;
+    {
+        ext::generator_t<int> generator = small_frame();
+        p_frame = generator.handle.address();
+    }
+    EXPECT_EQ(cached_blocks(pool), 1uz);
+    ext::generator_t<int> generator = small_frame();
+    EXPECT_EQ(generator.handle.address(), p_frame);
+    EXPECT_EQ(cached_blocks(pool), 0uz);
+}
+
+TEST(generator_frame_pool, explicit_allocator_uses_its_pool)
+{
+    ext::generator_frame_pool_t pool, pool_thread_local;
+    ext::generator_frame_pool_t::thread_local_scope_t scope(pool_thread_local);
+    EXPECT_EQ(collect(explicit_pool_frame(std::allocator_arg, pool)), (std::vector<int>{1}));
+    EXPECT_EQ(cached_blocks(pool), 1uz);
+    EXPECT_EQ(cached_blocks(pool_thread_local), 0uz);
+    EXPECT_EQ(collect(explicit_pool_frame(std::allocator_arg, pool)), (std::vector<int>{1}));
+    EXPECT_EQ(cached_blocks(pool), 1uz); // reused
+}
+
+TEST(generator_frame_pool, freed_under_another_scope_or_none)
+{
+    ext::generator_frame_pool_t pool_a, pool_b;
+    std::optional<ext::generator_t<int>> generator;
+    {
+        ext::generator_frame_pool_t::thread_local_scope_t scope(pool_a);
+        generator = small_frame();
+    }
+    {
+        ext::generator_frame_pool_t::thread_local_scope_t scope(pool_b);
+        generator.reset();
+    }
+    EXPECT_EQ(cached_blocks(pool_a), 0uz);
+    EXPECT_EQ(cached_blocks(pool_b), 1uz); // the block went to the pool in scope when it was freed
+
+    {
+        ext::generator_frame_pool_t::thread_local_scope_t scope(pool_b);
+        generator = small_frame(); // reuses pool_b's block
+    }
+    EXPECT_EQ(cached_blocks(pool_b), 0uz);
+    generator.reset(); // no pool: ::operator delete
+    EXPECT_EQ(cached_blocks(pool_b), 0uz);
+
+    generator = small_frame(); // no pool: ::operator new
+    {
+        ext::generator_frame_pool_t::thread_local_scope_t scope(pool_a);
+        generator.reset();
+    }
+    EXPECT_EQ(cached_blocks(pool_a), 1uz);
+    pool_a.release();
+}
+
+TEST(generator_frame_pool, nested_scopes_restore_the_previous_pool)
+{
+    EXPECT_EQ(ext::generator_frame_pool_t::p_thread_local, nullptr);
+    ext::generator_frame_pool_t pool_outer, pool_inner;
+    {
+        ext::generator_frame_pool_t::thread_local_scope_t scope_outer(pool_outer);
+        EXPECT_EQ(ext::generator_frame_pool_t::p_thread_local, &pool_outer);
+        {
+            ext::generator_frame_pool_t::thread_local_scope_t scope_inner(pool_inner);
+            EXPECT_EQ(ext::generator_frame_pool_t::p_thread_local, &pool_inner);
+            EXPECT_EQ(collect(small_frame()), (std::vector<int>{1}));
+        }
+        EXPECT_EQ(ext::generator_frame_pool_t::p_thread_local, &pool_outer);
+        EXPECT_EQ(collect(small_frame()), (std::vector<int>{1}));
+    }
+    EXPECT_EQ(ext::generator_frame_pool_t::p_thread_local, nullptr);
+    EXPECT_EQ(cached_blocks(pool_inner), 1uz);
+    EXPECT_EQ(cached_blocks(pool_outer), 1uz);
+}
+
+TEST(generator_frame_pool, release_empties_the_free_lists)
+{
+    constexpr std::size_t granularity = ext::generator_frame_pool_t::size_class_granularity;
+    ext::generator_frame_pool_t pool;
+    std::vector<std::pair<void *, std::size_t>> blocks;
+    for (std::size_t frame_size : {1uz, granularity, granularity + 1uz, granularity * 10uz, granularity * 64uz})
+        for (int i = 0; i != 3; ++i)
+            blocks.emplace_back(pool.allocate(frame_size), frame_size);
+    for (auto [p, frame_size] : blocks)
+        pool.deallocate(p, frame_size);
+    EXPECT_EQ(cached_blocks(pool), blocks.size());
+    pool.release();
+    EXPECT_EQ(cached_blocks(pool), 0uz);
+    pool.release();
+    pool.deallocate(pool.allocate(granularity), granularity); // still usable
+    EXPECT_EQ(cached_blocks(pool), 1uz);
+}
+
+TEST(generator_caching, lvalue_is_not_copied)
+{
+    counted_t const *p_local = nullptr;
+    ext::generator_t<counted_t const &, void, void, caching_traits_t> generator = [](counted_t const *&p_local) -> ext::generator_t<counted_t const &, void, void, caching_traits_t> {
+        counted_t local(1);
+        p_local = &local;
+        co_yield local;
+        local.value = 2;
+        co_yield local;
+    }(p_local);
+    counts = {};
+    auto iterator = generator.begin();
+    EXPECT_EQ(&*iterator, p_local);
+    ++iterator;
+    EXPECT_EQ(&*iterator, p_local);
+    EXPECT_EQ((*iterator).value, 2);
+    EXPECT_EQ(counts, (counts_t{}));
+}
+
+TEST(generator_caching, rvalue_is_moved_in_then_assigned)
+{
+    counts = {};
+    {
+        ext::generator_t<counted_t const &, void, void, caching_traits_t> generator = []() -> ext::generator_t<counted_t const &, void, void, caching_traits_t> {
+            co_yield counted_t(1);
+            co_yield counted_t(2);
+            co_yield counted_t(3);
+        }();
+        auto iterator = generator.begin();
+        counted_t const *p_stored = &*iterator;
+        EXPECT_EQ((*iterator).value, 1);
+        EXPECT_EQ(counts, (counts_t{.constructions = 1, .moves = 1})); // moved into the cache, the temporary lives until the coroutine resumes
+        ++iterator;
+        ++iterator;
+        EXPECT_EQ(&*iterator, p_stored); // the same object, assigned rather than re-constructed
+        EXPECT_EQ((*iterator).value, 3);
+        EXPECT_EQ(counts, (counts_t{.constructions = 3, .moves = 1, .move_assignments = 2, .destructions = 2}));
+    }
+    EXPECT_EQ(counts.destructions, 4);
+}
+
+TEST(generator_caching, converted_expression_is_stored)
+{
+    counts = {};
+    {
+        ext::generator_t<counted_t const &, void, void, caching_traits_t> generator = []() -> ext::generator_t<counted_t const &, void, void, caching_traits_t> {
+            co_yield 1; // constructs the cache from the int
+            co_yield 2;
+        }();
+        auto iterator = generator.begin();
+        EXPECT_EQ((*iterator).value, 1);
+        EXPECT_EQ(counts, (counts_t{.constructions = 1}));
+        ++iterator;
+        EXPECT_EQ((*iterator).value, 2);
+        EXPECT_EQ(counts, (counts_t{.constructions = 2, .move_assignments = 1, .destructions = 1}));
+    }
+
+    static constexpr char const *texts[] = {"a string that does not fit in the small string buffer", "a shorter one, still too long for it"};
+    ext::generator_t<std::string const &, void, void, caching_traits_t> generator = []() -> ext::generator_t<std::string const &, void, void, caching_traits_t> {
+        co_yield texts[0];
+        co_yield texts[1];
+    }();
+    auto iterator = generator.begin();
+    std::string const *p_stored = &*iterator;
+    char const *p_data = (*iterator).data();
+    EXPECT_EQ(*iterator, texts[0]);
+    ++iterator;
+    EXPECT_EQ(*iterator, texts[1]);
+    EXPECT_EQ(&*iterator, p_stored);
+    EXPECT_EQ((*iterator).data(), p_data); // the capacity is reused
+}
+
+TEST(generator_caching, rvalue_reference_consumer_moves_out)
+{
+    counts = {};
+    ext::generator_t<counted_t, void, void, caching_traits_t> generator = []() -> ext::generator_t<counted_t, void, void, caching_traits_t> {
+        counted_t local(1);
+        co_yield local; // yielded_t is counted_t &&, so the lvalue is copied into the cache
+        local.value = 2;
+        co_yield local;
+        EXPECT_EQ(local.value, 2); // not moved from
+    }();
+    std::vector<counted_t> taken;
+    taken.reserve(2uz);
+    for (counted_t &&e : generator)
+        taken.push_back(std::move(e));
+    EXPECT_EQ(taken[0].value, 1);
+    EXPECT_EQ(taken[1].value, 2);
+    EXPECT_EQ(counts, (counts_t{.constructions = 1, .copies = 1, .moves = 2, .copy_assignments = 1, .destructions = 1})); // copied into the cache once, the moved-from cache is assigned again; only local is destroyed so far
+}
+
+TEST(generator_graft_started, order_across_each_pop)
+{
+    bool caught = false;
+    EXPECT_EQ(collect(graft_after(nest(4), 3, 100, caught)), (std::vector<int>{10, 11, 21, 31, 41, 100})); // grafted while its active frame is 3 below it
+    EXPECT_EQ(collect(graft_after(graft_after(graft_after(nest(5), 1, 100, caught), 1, 200, caught), 1, 300, caught)), (std::vector<int>{20, 10, 11, 21, 31, 41, 51, 100, 200, 300})); // each graft_after grafts a started tree whose active frame is below its root
+    EXPECT_EQ(collect(graft_after(graft_after(nest(3), 5, 100, caught), 0, 200, caught)), (std::vector<int>{31, 100, 200})); // the subtree's root is its active frame again
+    EXPECT_FALSE(caught);
+}
+
+TEST(generator_graft_started, exception_reaches_the_catching_co_yield)
+{
+    for (int catch_at : {2, 3, 4})
+    {
+        bool caught = false;
+        std::vector<int> expected{10, -catch_at};
+        for (int level = catch_at; level != 5; ++level)
+            expected.push_back(level * 10 + 1);
+        expected.push_back(100);
+        EXPECT_EQ(collect(graft_after(nest_throwing(4, catch_at), 3, 100, caught)), expected) << "catch_at = " << catch_at;
+        EXPECT_FALSE(caught);
+    }
+    bool caught = false;
+    EXPECT_EQ(collect(graft_after(nest_throwing(4, 0), 3, 100, caught)), (std::vector<int>{10, 100})); // caught by the co_yield which grafted the started subtree
+    EXPECT_TRUE(caught);
+
+    bool caught_inner = false, caught_outer = false;
+    EXPECT_EQ(collect(graft_after(graft_after(nest_throwing(4, 3), 2, 100, caught_inner), 1, 200, caught_outer)), (std::vector<int>{10, -3, 31, 41, 100, 200}));
+    EXPECT_FALSE(caught_inner);
+    EXPECT_FALSE(caught_outer);
+    EXPECT_EQ(collect(graft_after(graft_after(nest_throwing(4, 0), 2, 100, caught_inner), 1, 200, caught_outer)), (std::vector<int>{10, 100, 200}));
+    EXPECT_TRUE(caught_inner);
+    EXPECT_FALSE(caught_outer);
+}
+
+TEST(generator_teardown, abandon_deep_lazy_chain_at_leaf)
+{
+    constexpr int depth = 1000000;
+    teardown_t teardown;
+    {
+        ext::lazy_generator_t<int> generator = lazy_chain(depth, teardown);
+        auto iterator = generator.begin();
+        for (int i = 1; i != depth; ++i)
+            ++iterator;
+        EXPECT_EQ(*iterator, 1);
+    } // destroys the chain from the leaf, without recursing once per frame
+    EXPECT_EQ(teardown.destroyed, depth);
+    EXPECT_TRUE(teardown.leaf_first);
+}
+
+TEST(generator_size_hint, follows_the_current_range)
+{
+    std::vector<std::vector<int>> vs{{1, 2}, {3, 4, 5, 6, 7, 8, 9, 10}};
+    ext::generator_t<int const &> generator = ranges_of(vs);
+    EXPECT_EQ(generator.size_hint(), 2uz);
+    auto iterator = generator.begin();
+    ++iterator;
+    EXPECT_EQ(*iterator, 2);
+    EXPECT_EQ(generator.size_hint(), 1uz);
+    ++iterator;
+    EXPECT_EQ(*iterator, 3);
+    EXPECT_EQ(generator.size_hint(), 8uz);
+    for (int i = 3; i != 10; ++i)
+        ++iterator;
+    EXPECT_EQ(*iterator, 10);
+    EXPECT_EQ(generator.size_hint(), 1uz);
+    ++iterator;
+    EXPECT_EQ(*iterator, -1);
+    EXPECT_EQ(generator.size_hint(), 0uz); // the ranges are used up
+}
+
+TEST(generator_size_hint, non_contiguous_and_grafted)
+{
+    ext::generator_t<int const &> generator = iota_then_nested(4);
+    EXPECT_EQ(generator.size_hint(), 4uz);
+    auto iterator = generator.begin();
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 3uz);
+    for (int i = 1; i != 4; ++i)
+        ++iterator;
+    EXPECT_EQ(*iterator, 7);
+    EXPECT_EQ(generator.size_hint(), 0uz); // only the root's own ranges count
+}
+
+TEST(generator_size_hint, declared_counts_down)
+{
+    ext::generator_t<int const &> generator = declared(6);
+    EXPECT_EQ(generator.size_hint(), 6uz);
+    auto iterator = generator.begin();
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 5uz);
+    for (int i = 1; i != 5; ++i)
+        ++iterator;
+    EXPECT_EQ(*iterator, 5);
+    EXPECT_EQ(generator.size_hint(), 1uz);
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 0uz);
+
+    generator = []() -> ext::generator_t<int const &> {
+        co_yield ext::generator_size_hint_t{.size = 2uz};
+        co_yield 1;
+        co_yield 2;
+        co_yield ext::generator_size_hint_t{.size = 10uz}; // declared again
+        co_yield 3;
+    }();
+    iterator = generator.begin();
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 1uz);
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 10uz);
+
+    generator = []() -> ext::generator_t<int const &> {
+        co_yield ext::generator_size_hint_t{.size = 2uz}; // too few
+        co_yield std::ranges::elements_of(std::views::iota(0, 5));
+    }();
+    iterator = generator.begin();
+    ++iterator;
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 3uz); // once used up, the rest of the range
+}
+
+TEST(generator_size_hint, declared_counts_down_by_chunk)
+{
+    std::vector<std::vector<int>> vs{{1, 2, 3, 4}};
+    ext::generator_t<int const &> generator = [](std::vector<std::vector<int>> const &vs) -> ext::generator_t<int const &> {
+        co_yield ext::generator_size_hint_t{.size = 6uz};
+        co_yield std::ranges::elements_of(ranges_of(vs)); // 1 2 3 4 -1
+        co_yield -2;
+    }(vs);
+    auto iterator = generator.begin();
+    ++iterator;
+    EXPECT_EQ(generator.size_hint(), 5uz);
+    auto chunk_iterator = generator.chunks().begin();
+    EXPECT_EQ((*chunk_iterator).size(), 3uz);
+    ++chunk_iterator;
+    EXPECT_EQ(generator.size_hint(), 2uz);
+    ++chunk_iterator;
+    ++chunk_iterator;
+    EXPECT_EQ(generator.size_hint(), 0uz);
+}
+
+TEST(generator_size_hint, drain_into)
+{
+    std::vector<std::vector<int>> vs{{1, 2}, {3, 4, 5, 6, 7, 8, 9, 10}};
+    std::vector<int> elements;
+    ranges_of(vs).drain_into(elements);
+    EXPECT_EQ(elements, (std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1}));
+
+    std::vector<std::vector<int>> ws{{1, 2, 3, 4, 5, 6, 7, 8}, {9, 10}};
+    ext::generator_t<int const &> generator = ranges_of(ws);
+    auto iterator = generator.begin();
+    for (int i = 0; i != 9; ++i)
+        ++iterator;
+    std::vector<int> rest;
+    generator.drain_into(rest);
+    EXPECT_EQ(rest, (std::vector<int>{10, -1}));
+    EXPECT_LT(rest.capacity(), 8uz); // reserved for what is left of the current range, not for the consumed first range
+
+    generator = declared(1000);
+    iterator = generator.begin();
+    for (int i = 0; i != 999; ++i)
+        ++iterator;
+    EXPECT_EQ(generator.size_hint(), 1uz);
+    rest.clear();
+    rest.shrink_to_fit();
+    generator.drain_into(rest);
+    EXPECT_EQ(rest, (std::vector<int>{999}));
+    EXPECT_LT(rest.capacity(), 1000uz); // reserved for what is left of the declared elements
+
+    elements.clear();
+    iota_then_nested(4).drain_into(elements);
+    EXPECT_EQ(elements, (std::vector<int>{0, 1, 2, 3, 7, 7, 7, 7, 7, -1}));
+}